@@ -0,0 +1,243 @@
+// Parses layout files against the host stub and reports, per file and way of
+// loading it, the mean parse time, the allocations made while parsing and the
+// peak heap above what was in use before the layout was created.
+//
+//   bench [-n iterations] [--arena size] [--tokenize] file...
+//   bench [-n iterations] --frames
+//
+// JSON files are parsed from a string, from a resource and streamed from a
+// resource. Files ending in .bin are loaded as compiled layouts. BitmapLayers
+// get a resource named "icon", as written by tools/gen_layout.py.
+//
+// --tokenize times only tokenizing each JSON file instead, with the two jsmn
+// passes json_create() used to make and with the delimiter scan and single
+// jsmn pass it makes now.
+//
+// --frames reads a generated array of frames with layout_next_rect() and
+// reports the time and allocations per frame.
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "json-internals.h"
+#include "layout-internals.h"
+
+#define RESOURCE_ID_ICON 1
+#define RESOURCE_ID_LAYOUT 2
+#define NUM_FRAMES 1000
+
+typedef enum {
+    ParseString,
+    ParseResource,
+    ParseStreaming,
+    ParseBinary,
+    ParseModeCount
+} ParseMode;
+
+static const char *MODE_NAMES[ParseModeCount] = {"string", "resource", "stream", "binary"};
+
+static int s_iterations = 20;
+static size_t s_arena_size;
+static bool s_tokenize;
+static bool s_frames;
+
+static double prv_now_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+static char *prv_read_file(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    rewind(file);
+    char *data = malloc(length + 1);
+    if (fread(data, 1, length, file) != (size_t) length) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    data[length] = '\0';
+    fclose(file);
+    *size = length;
+    return data;
+}
+
+static bool prv_ends_with(const char *s, const char *suffix) {
+    size_t length = strlen(s);
+    size_t suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(s + length - suffix_length, suffix) == 0;
+}
+
+static Layout *prv_parse(ParseMode mode, const char *data) {
+    Layout *layout = s_arena_size ? layout_create_with_arena(s_arena_size) : layout_create();
+    layout_add_all_standard_types(layout);
+    layout_add_resource(layout, "icon", RESOURCE_ID_ICON);
+    switch (mode) {
+        case ParseString: layout_parse(layout, data); break;
+        case ParseResource: layout_parse_resource(layout, RESOURCE_ID_LAYOUT); break;
+        case ParseStreaming: layout_parse_resource_streaming(layout, RESOURCE_ID_LAYOUT); break;
+        default: layout_parse_binary_resource(layout, RESOURCE_ID_LAYOUT); break;
+    }
+    return layout;
+}
+
+static void prv_bench(const char *path, ParseMode mode, const char *data) {
+    double total_us = 0;
+    size_t allocs = 0;
+    size_t peak = 0;
+    bool has_root = false;
+    for (int i = 0; i < s_iterations; i++) {
+        StubHeapStats before;
+        StubHeapStats after;
+        stub_reset_heap_peak();
+        stub_get_heap_stats(&before);
+        double start = prv_now_us();
+        Layout *layout = prv_parse(mode, data);
+        total_us += prv_now_us() - start;
+        stub_get_heap_stats(&after);
+        allocs = after.allocs - before.allocs;
+        peak = after.peak - before.live;
+        has_root = layout_get_layer(layout) != NULL;
+        layout_destroy(layout);
+    }
+    printf("%-32s %-8s %10.2f %8zu %10zu%s\n", path, MODE_NAMES[mode], total_us / s_iterations / 1000,
+           allocs, peak, has_root ? "" : "  (no root)");
+}
+
+// One jsmn pass to count the tokens and another to fill them in.
+static int prv_tokenize_two_pass(const char *data, size_t size) {
+    jsmn_parser parser;
+    jsmn_init(&parser);
+    int num_tokens = jsmn_parse(&parser, data, size, NULL, 0);
+    if (num_tokens < 0) return num_tokens;
+
+    jsmntok_t *tokens = malloc(sizeof(jsmntok_t) * num_tokens);
+    jsmn_init(&parser);
+    num_tokens = jsmn_parse(&parser, data, size, tokens, num_tokens);
+    free(tokens);
+    return num_tokens;
+}
+
+static void prv_bench_tokenize(const char *path, const char *data, size_t size) {
+    double two_pass_us = 0;
+    double single_pass_us = 0;
+    int num_tokens = 0;
+    for (int i = 0; i < s_iterations; i++) {
+        double start = prv_now_us();
+        num_tokens = prv_tokenize_two_pass(data, size);
+        two_pass_us += prv_now_us() - start;
+
+        start = prv_now_us();
+        jsmntok_t *tokens;
+        size_t tokens_size;
+        json_tokenize(data, size, &tokens, &tokens_size);
+        free(tokens);
+        single_pass_us += prv_now_us() - start;
+    }
+    printf("%-32s %8d %12.3f %12.3f\n", path, num_tokens, two_pass_us / s_iterations / 1000,
+           single_pass_us / s_iterations / 1000);
+}
+
+// Half the frames are arrays and half objects, the two forms a layout can
+// use.
+static void prv_bench_frames(void) {
+    char *data = malloc(NUM_FRAMES * 48 + 3);
+    size_t len = 0;
+    data[len++] = '[';
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        const char *format = i % 2 ? "{\"x\":%d,\"y\":%d,\"w\":%d,\"h\":%d}," : "[%d,%d,%d,%d],";
+        len += sprintf(data + len, format, i % 144, -i % 168, 144, 20 + i % 100);
+    }
+    data[len - 1] = ']';
+    data[len] = '\0';
+
+    Json *json = json_create(data, false);
+    JsonMark start = json_mark(json);
+    double total_us = 0;
+    size_t allocs = 0;
+    int checksum = 0;
+    for (int i = 0; i < s_iterations; i++) {
+        StubHeapStats before;
+        StubHeapStats after;
+        json_reset(json, start);
+        stub_get_heap_stats(&before);
+        double start_us = prv_now_us();
+        for (int j = 0; j < NUM_FRAMES; j++) checksum += layout_next_rect(json).size.h;
+        total_us += prv_now_us() - start_us;
+        stub_get_heap_stats(&after);
+        allocs += after.allocs - before.allocs;
+    }
+    json_destroy(json);
+    free(data);
+
+    double frames = (double) NUM_FRAMES * s_iterations;
+    printf("%-32s %8d %12.1f %12.2f%s\n", "frames", NUM_FRAMES, total_us * 1000 / frames, allocs / frames,
+           checksum ? "" : "  (no frames)");
+}
+
+int main(int argc, char **argv) {
+    static const char icon[] = "icon";
+    stub_add_resource(RESOURCE_ID_ICON, icon, sizeof(icon));
+
+    int first = 1;
+    while (first < argc && argv[first][0] == '-') {
+        if (strcmp(argv[first], "-n") == 0 && first + 1 < argc) {
+            s_iterations = atoi(argv[first + 1]);
+        } else if (strcmp(argv[first], "--arena") == 0 && first + 1 < argc) {
+            s_arena_size = strtoul(argv[first + 1], NULL, 10);
+        } else if (strcmp(argv[first], "--tokenize") == 0) {
+            s_tokenize = true;
+            first += 1;
+            continue;
+        } else if (strcmp(argv[first], "--frames") == 0) {
+            s_frames = true;
+            first += 1;
+            continue;
+        } else {
+            first = argc;
+            break;
+        }
+        first += 2;
+    }
+    if ((first >= argc && !s_frames) || s_iterations < 1) {
+        fprintf(stderr, "usage: %s [-n iterations] [--arena size] [--tokenize] file...\n", argv[0]);
+        fprintf(stderr, "       %s [-n iterations] --frames\n", argv[0]);
+        return 1;
+    }
+
+    if (s_frames) {
+        printf("%-32s %8s %12s %12s\n", "", "frames", "ns/frame", "allocs/frame");
+        prv_bench_frames();
+        return 0;
+    }
+
+    if (s_tokenize) {
+        printf("%-32s %8s %12s %12s\n", "file", "tokens", "two-pass ms", "single ms");
+    } else {
+        printf("%-32s %-8s %10s %8s %10s\n", "file", "mode", "parse ms", "allocs", "peak heap");
+    }
+    for (int i = first; i < argc; i++) {
+        size_t size;
+        char *data = prv_read_file(argv[i], &size);
+        if (!data) {
+            fprintf(stderr, "can't read %s\n", argv[i]);
+            return 1;
+        }
+        stub_add_resource(RESOURCE_ID_LAYOUT, data, size);
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        if (s_tokenize) {
+            if (!prv_ends_with(argv[i], ".bin")) prv_bench_tokenize(name, data, size);
+        } else if (prv_ends_with(argv[i], ".bin")) {
+            prv_bench(name, ParseBinary, data);
+        } else {
+            prv_bench(name, ParseString, data);
+            prv_bench(name, ParseResource, data);
+            prv_bench(name, ParseStreaming, data);
+        }
+        free(data);
+    }
+    return 0;
+}
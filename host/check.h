@@ -0,0 +1,12 @@
+#pragma once
+#include <pebble.h>
+
+// Aborts the test with the failing condition. Unlike assert() this stays on
+// in release builds, which is what the benchmark configuration uses.
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1); \
+        } \
+    } while (0)
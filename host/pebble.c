@@ -0,0 +1,581 @@
+#include <pebble.h>
+
+// The real allocator, underneath the counting one.
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+#define MAX_RESOURCES 64
+#define MAX_SYSTEM_FONTS 64
+#define MAX_TIMERS 32
+
+// Anything the library stores, for keeping payloads aligned.
+typedef union {
+    void *pointer;
+    long long integer;
+    long double real;
+} Align;
+
+// Each block starts with its size, padded to keep the payload aligned.
+typedef union {
+    size_t size;
+    Align align;
+} Header;
+
+static StubHeapStats s_heap;
+
+void *stub_malloc(size_t size) {
+    Header *header = malloc(sizeof(Header) + size);
+    if (!header) {
+        return NULL;
+    }
+    header->size = size;
+    s_heap.allocs++;
+    s_heap.live += size;
+    if (s_heap.live > s_heap.peak) {
+        s_heap.peak = s_heap.live;
+    }
+    return header + 1;
+}
+
+void *stub_calloc(size_t count, size_t size) {
+    void *ptr = stub_malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+// Always moves the block, so code that keeps a pointer across a realloc
+// fails under a sanitizer here rather than only on the watch.
+void *stub_realloc(void *ptr, size_t size) {
+    if (!ptr) {
+        return stub_malloc(size);
+    }
+    size_t old_size = ((Header *) ptr - 1)->size;
+    void *moved = stub_malloc(size);
+    if (moved) {
+        memcpy(moved, ptr, old_size < size ? old_size : size);
+        stub_free(ptr);
+    }
+    return moved;
+}
+
+void stub_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    Header *header = (Header *) ptr - 1;
+    s_heap.frees++;
+    s_heap.live -= header->size;
+    free(header);
+}
+
+void stub_get_heap_stats(StubHeapStats *stats) {
+    *stats = s_heap;
+}
+
+void stub_reset_heap_peak(void) {
+    s_heap.peak = s_heap.live;
+}
+
+size_t heap_bytes_used(void) {
+    return s_heap.live;
+}
+
+static uint16_t s_clock_step;
+static struct timespec s_clock;
+
+void stub_set_clock_step(uint16_t step) {
+    s_clock_step = step;
+    s_clock = (struct timespec) { 0 };
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+    struct timespec now;
+    if (s_clock_step) {
+        s_clock.tv_nsec += s_clock_step * 1000000L;
+        s_clock.tv_sec += s_clock.tv_nsec / 1000000000L;
+        s_clock.tv_nsec %= 1000000000L;
+        now = s_clock;
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+    uint16_t ms = (uint16_t) (now.tv_nsec / 1000000);
+    if (tloc) {
+        *tloc = now.tv_sec;
+    }
+    if (out_ms) {
+        *out_ms = ms;
+    }
+    return ms;
+}
+
+// Graphics
+
+bool grect_equal(const GRect *a, const GRect *b) {
+    return a->origin.x == b->origin.x && a->origin.y == b->origin.y &&
+           a->size.w == b->size.w && a->size.h == b->size.h;
+}
+
+bool gcolor_equal(GColor8 a, GColor8 b) {
+    return a.argb == b.argb;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+}
+
+// Layers
+
+struct Layer {
+    GRect frame;
+    GRect bounds;
+    Layer *parent;
+    Layer *first_child;
+    Layer *next_sibling;
+    bool hidden;
+    bool clips;
+    LayerUpdateProc update_proc;
+    Align data[];
+};
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+    Layer *layer = stub_calloc(1, sizeof(Layer) + data_size);
+    layer->frame = frame;
+    layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+    layer->clips = true;
+    return layer;
+}
+
+Layer *layer_create(GRect frame) {
+    return layer_create_with_data(frame, 0);
+}
+
+void *layer_get_data(const Layer *layer) {
+    return (void *) layer->data;
+}
+
+void layer_remove_from_parent(Layer *child) {
+    if (!child->parent) {
+        return;
+    }
+    Layer **link = &child->parent->first_child;
+    while (*link != child) {
+        link = &(*link)->next_sibling;
+    }
+    *link = child->next_sibling;
+    child->parent = NULL;
+    child->next_sibling = NULL;
+}
+
+void layer_destroy(Layer *layer) {
+    if (!layer) {
+        return;
+    }
+    layer_remove_from_parent(layer);
+    for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+        child->parent = NULL;
+    }
+    stub_free(layer);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+    layer->update_proc = update_proc;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+    layer_remove_from_parent(child);
+    Layer **link = &parent->first_child;
+    while (*link) {
+        link = &(*link)->next_sibling;
+    }
+    *link = child;
+    child->parent = parent;
+}
+
+void layer_insert_above_sibling(Layer *layer, Layer *sibling) {
+    layer_remove_from_parent(layer);
+    layer->next_sibling = sibling->next_sibling;
+    sibling->next_sibling = layer;
+    layer->parent = sibling->parent;
+}
+
+void layer_insert_below_sibling(Layer *layer, Layer *sibling) {
+    layer_remove_from_parent(layer);
+    Layer **link = &sibling->parent->first_child;
+    while (*link != sibling) {
+        link = &(*link)->next_sibling;
+    }
+    layer->next_sibling = sibling;
+    *link = layer;
+    layer->parent = sibling->parent;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+    return layer->frame;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+    layer->frame = frame;
+    layer->bounds.size = frame.size;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+    return layer->bounds;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+    layer->bounds = bounds;
+}
+
+bool layer_get_clips(const Layer *layer) {
+    return layer->clips;
+}
+
+void layer_set_clips(Layer *layer, bool clips) {
+    layer->clips = clips;
+}
+
+bool layer_get_hidden(const Layer *layer) {
+    return layer->hidden;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+    layer->hidden = hidden;
+}
+
+void layer_mark_dirty(Layer *layer) {
+}
+
+Layer *stub_layer_get_parent(const Layer *layer) {
+    return layer->parent;
+}
+
+int stub_layer_count_children(const Layer *layer) {
+    int count = 0;
+    for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+        count++;
+    }
+    return count;
+}
+
+struct TextLayer {
+    Layer *layer;
+    const char *text;
+    GColor background_color;
+    GColor text_color;
+    GTextAlignment alignment;
+    GFont font;
+};
+
+TextLayer *text_layer_create(GRect frame) {
+    TextLayer *text_layer = stub_calloc(1, sizeof(TextLayer));
+    text_layer->layer = layer_create(frame);
+    text_layer->background_color = GColorWhite;
+    text_layer->text_color = GColorBlack;
+    return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+    layer_destroy(text_layer->layer);
+    stub_free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+    return text_layer->layer;
+}
+
+const char *text_layer_get_text(TextLayer *text_layer) {
+    return text_layer->text;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+    text_layer->text = text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+    text_layer->background_color = color;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+    text_layer->text_color = color;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment alignment) {
+    text_layer->alignment = alignment;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+    text_layer->font = font;
+}
+
+GColor stub_text_layer_get_text_color(TextLayer *text_layer) {
+    return text_layer->text_color;
+}
+
+GColor stub_text_layer_get_background_color(TextLayer *text_layer) {
+    return text_layer->background_color;
+}
+
+GTextAlignment stub_text_layer_get_alignment(TextLayer *text_layer) {
+    return text_layer->alignment;
+}
+
+GFont stub_text_layer_get_font(TextLayer *text_layer) {
+    return text_layer->font;
+}
+
+struct GBitmap {
+    GRect bounds;
+};
+
+static int s_bitmaps;
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+    GBitmap *bitmap = stub_calloc(1, sizeof(GBitmap));
+    bitmap->bounds = GRect(0, 0, 64, 64);
+    s_bitmaps++;
+    return bitmap;
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect) {
+    GBitmap *bitmap = stub_calloc(1, sizeof(GBitmap));
+    bitmap->bounds = sub_rect;
+    s_bitmaps++;
+    return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+    s_bitmaps--;
+    stub_free(bitmap);
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+    return bitmap->bounds;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+    return 64;
+}
+
+int stub_count_bitmaps(void) {
+    return s_bitmaps;
+}
+
+struct BitmapLayer {
+    Layer *layer;
+    const GBitmap *bitmap;
+};
+
+BitmapLayer *bitmap_layer_create(GRect frame) {
+    BitmapLayer *bitmap_layer = stub_calloc(1, sizeof(BitmapLayer));
+    bitmap_layer->layer = layer_create(frame);
+    return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer) {
+    layer_destroy(bitmap_layer->layer);
+    stub_free(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer) {
+    return bitmap_layer->layer;
+}
+
+const GBitmap *bitmap_layer_get_bitmap(BitmapLayer *bitmap_layer) {
+    return bitmap_layer->bitmap;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap) {
+    bitmap_layer->bitmap = bitmap;
+}
+
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color) {
+}
+
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment) {
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode) {
+}
+
+struct StatusBarLayer {
+    Layer *layer;
+    GColor background_color;
+    GColor foreground_color;
+};
+
+StatusBarLayer *status_bar_layer_create(void) {
+    StatusBarLayer *status_bar_layer = stub_calloc(1, sizeof(StatusBarLayer));
+    status_bar_layer->layer = layer_create(GRect(0, 0, PBL_DISPLAY_WIDTH, 16));
+    return status_bar_layer;
+}
+
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer) {
+    layer_destroy(status_bar_layer->layer);
+    stub_free(status_bar_layer);
+}
+
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer) {
+    return status_bar_layer->layer;
+}
+
+GColor status_bar_layer_get_background_color(const StatusBarLayer *status_bar_layer) {
+    return status_bar_layer->background_color;
+}
+
+GColor status_bar_layer_get_foreground_color(const StatusBarLayer *status_bar_layer) {
+    return status_bar_layer->foreground_color;
+}
+
+void status_bar_layer_set_colors(StatusBarLayer *status_bar_layer, GColor background, GColor foreground) {
+    status_bar_layer->background_color = background;
+    status_bar_layer->foreground_color = foreground;
+}
+
+void status_bar_layer_set_separator_mode(StatusBarLayer *status_bar_layer, StatusBarLayerSeparatorMode mode) {
+}
+
+struct GDrawCommandImage {
+    uint32_t resource_id;
+};
+
+GDrawCommandImage *gdraw_command_image_create_with_resource(uint32_t resource_id) {
+    GDrawCommandImage *image = stub_calloc(1, sizeof(GDrawCommandImage));
+    image->resource_id = resource_id;
+    return image;
+}
+
+void gdraw_command_image_destroy(GDrawCommandImage *image) {
+    stub_free(image);
+}
+
+void gdraw_command_image_draw(GContext *ctx, GDrawCommandImage *image, GPoint offset) {
+}
+
+// Resources and fonts
+
+typedef struct {
+    uint32_t resource_id;
+    const uint8_t *data;
+    size_t length;
+} Resource;
+
+static Resource s_resources[MAX_RESOURCES];
+static int s_num_resources;
+
+void stub_add_resource(uint32_t resource_id, const void *data, size_t length) {
+    for (int i = 0; i < s_num_resources; i++) {
+        if (s_resources[i].resource_id == resource_id) {
+            s_resources[i].data = data;
+            s_resources[i].length = length;
+            return;
+        }
+    }
+    if (s_num_resources < MAX_RESOURCES) {
+        s_resources[s_num_resources++] = (Resource) {resource_id, data, length};
+    }
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+    for (int i = 0; i < s_num_resources; i++) {
+        if (s_resources[i].resource_id == resource_id) {
+            return &s_resources[i];
+        }
+    }
+    return NULL;
+}
+
+size_t resource_size(ResHandle handle) {
+    return ((Resource *) handle)->length;
+}
+
+size_t resource_load_byte_range(ResHandle handle, uint32_t start_offset, uint8_t *buffer, size_t num_bytes) {
+    Resource *resource = handle;
+    if (start_offset >= resource->length) {
+        return 0;
+    }
+    size_t available = resource->length - start_offset;
+    size_t length = num_bytes < available ? num_bytes : available;
+    memcpy(buffer, resource->data + start_offset, length);
+    return length;
+}
+
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length) {
+    return resource_load_byte_range(handle, 0, buffer, max_length);
+}
+
+struct FontInfo {
+    const char *font_key;
+};
+
+static FontInfo s_system_fonts[MAX_SYSTEM_FONTS];
+static int s_num_system_fonts;
+static int s_custom_fonts;
+
+GFont fonts_get_system_font(const char *font_key) {
+    for (int i = 0; i < s_num_system_fonts; i++) {
+        if (strcmp(s_system_fonts[i].font_key, font_key) == 0) {
+            return &s_system_fonts[i];
+        }
+    }
+    if (s_num_system_fonts == MAX_SYSTEM_FONTS) {
+        return NULL;
+    }
+    s_system_fonts[s_num_system_fonts].font_key = font_key;
+    return &s_system_fonts[s_num_system_fonts++];
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+    s_custom_fonts++;
+    return stub_calloc(1, sizeof(FontInfo));
+}
+
+void fonts_unload_custom_font(GFont font) {
+    s_custom_fonts--;
+    stub_free(font);
+}
+
+int stub_count_custom_fonts(void) {
+    return s_custom_fonts;
+}
+
+// Timers
+
+struct AppTimer {
+    AppTimerCallback callback;
+    void *callback_data;
+    bool scheduled;
+};
+
+static AppTimer s_timers[MAX_TIMERS];
+static int s_num_timers;
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    if (s_num_timers == MAX_TIMERS) {
+        return NULL;
+    }
+    AppTimer *timer = &s_timers[s_num_timers++];
+    *timer = (AppTimer) {callback, callback_data, true};
+    return timer;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+    timer->scheduled = false;
+}
+
+void stub_run_timers(void) {
+    int num_timers = s_num_timers;
+    AppTimer timers[MAX_TIMERS];
+    memcpy(timers, s_timers, sizeof(AppTimer) * num_timers);
+    s_num_timers = 0;
+    for (int i = 0; i < num_timers; i++) {
+        if (timers[i].scheduled) {
+            timers[i].callback(timers[i].callback_data);
+        }
+    }
+}
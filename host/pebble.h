@@ -0,0 +1,308 @@
+#pragma once
+// A stand-in for the parts of the Pebble SDK that pebble-layout uses, so the
+// library builds and runs on the host for tests and benchmarks. Layers,
+// bitmaps and fonts are plain structs; nothing is drawn.
+//
+// Every allocation the library makes goes through the stub's counting
+// allocator, which backs heap_bytes_used() and stub_get_heap_stats().
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void *stub_malloc(size_t size);
+void *stub_calloc(size_t count, size_t size);
+void *stub_realloc(void *ptr, size_t size);
+void stub_free(void *ptr);
+
+#define malloc(size) stub_malloc(size)
+#define calloc(count, size) stub_calloc(count, size)
+#define realloc(ptr, size) stub_realloc(ptr, size)
+#define free(ptr) stub_free(ptr)
+
+typedef struct {
+    size_t allocs;
+    size_t frees;
+    size_t live;
+    size_t peak;
+} StubHeapStats;
+
+void stub_get_heap_stats(StubHeapStats *stats);
+void stub_reset_heap_peak(void);
+size_t heap_bytes_used(void);
+
+#define ARRAY_LENGTH(array) (sizeof((array)) / sizeof((array)[0]))
+
+typedef enum {
+    APP_LOG_LEVEL_ERROR = 1,
+    APP_LOG_LEVEL_WARNING = 50,
+    APP_LOG_LEVEL_INFO = 100,
+    APP_LOG_LEVEL_DEBUG = 200
+} AppLogLevel;
+
+#define APP_LOG(level, fmt, ...) fprintf(stderr, "[%d] " fmt "\n", (int) (level), ##__VA_ARGS__)
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+
+// Makes the clock move on by step ms each time it's read instead of following
+// real time, so tests can check timings. 0 goes back to real time.
+void stub_set_clock_step(uint16_t step);
+
+// Graphics
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+typedef struct {
+    int16_t w;
+    int16_t h;
+} GSize;
+
+typedef struct {
+    GPoint origin;
+    GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GSize(w, h) ((GSize){(w), (h)})
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GPointZero GPoint(0, 0)
+#define GRectZero GRect(0, 0, 0, 0)
+
+bool grect_equal(const GRect *a, const GRect *b);
+
+typedef union {
+    uint8_t argb;
+    struct {
+        uint8_t b:2;
+        uint8_t g:2;
+        uint8_t r:2;
+        uint8_t a:2;
+    };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorClear ((GColor8){.argb = 0x00})
+#define GColorBlack ((GColor8){.argb = 0xC0})
+#define GColorWhite ((GColor8){.argb = 0xFF})
+#define GColorFromHEX(v) ((GColor8){.argb = (uint8_t) (0xC0 | ((((v) >> 22) & 3) << 4) | \
+                                                       ((((v) >> 14) & 3) << 2) | (((v) >> 6) & 3))})
+
+bool gcolor_equal(GColor8 a, GColor8 b);
+
+typedef struct GContext GContext;
+
+typedef enum {
+    GCornerNone = 0
+} GCornerMask;
+
+typedef enum {
+    GAlignCenter,
+    GAlignTopLeft,
+    GAlignTopRight,
+    GAlignTop,
+    GAlignLeft,
+    GAlignBottom,
+    GAlignRight,
+    GAlignBottomRight,
+    GAlignBottomLeft
+} GAlign;
+
+typedef enum {
+    GCompOpAssign,
+    GCompOpAssignInverted,
+    GCompOpOr,
+    GCompOpAnd,
+    GCompOpClear,
+    GCompOpSet
+} GCompOp;
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+
+// Layers
+
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void *layer_get_data(const Layer *layer);
+void layer_destroy(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_insert_above_sibling(Layer *layer, Layer *sibling);
+void layer_insert_below_sibling(Layer *layer, Layer *sibling);
+void layer_remove_from_parent(Layer *child);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_bounds(const Layer *layer);
+void layer_set_bounds(Layer *layer, GRect bounds);
+bool layer_get_clips(const Layer *layer);
+void layer_set_clips(Layer *layer, bool clips);
+bool layer_get_hidden(const Layer *layer);
+void layer_set_hidden(Layer *layer, bool hidden);
+void layer_mark_dirty(Layer *layer);
+
+Layer *stub_layer_get_parent(const Layer *layer);
+int stub_layer_count_children(const Layer *layer);
+
+typedef struct FontInfo FontInfo;
+typedef FontInfo *GFont;
+
+typedef enum {
+    GTextAlignmentLeft,
+    GTextAlignmentCenter,
+    GTextAlignmentRight
+} GTextAlignment;
+
+typedef struct TextLayer TextLayer;
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+const char *text_layer_get_text(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment alignment);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+
+GColor stub_text_layer_get_text_color(TextLayer *text_layer);
+GColor stub_text_layer_get_background_color(TextLayer *text_layer);
+GTextAlignment stub_text_layer_get_alignment(TextLayer *text_layer);
+GFont stub_text_layer_get_font(TextLayer *text_layer);
+
+typedef struct GBitmap GBitmap;
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+
+int stub_count_bitmaps(void);
+
+typedef struct BitmapLayer BitmapLayer;
+
+BitmapLayer *bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer);
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer);
+const GBitmap *bitmap_layer_get_bitmap(BitmapLayer *bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap);
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color);
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment);
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode);
+
+typedef enum {
+    StatusBarLayerSeparatorModeNone,
+    StatusBarLayerSeparatorModeDotted
+} StatusBarLayerSeparatorMode;
+
+typedef struct StatusBarLayer StatusBarLayer;
+
+StatusBarLayer *status_bar_layer_create(void);
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer);
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer);
+GColor status_bar_layer_get_background_color(const StatusBarLayer *status_bar_layer);
+GColor status_bar_layer_get_foreground_color(const StatusBarLayer *status_bar_layer);
+void status_bar_layer_set_colors(StatusBarLayer *status_bar_layer, GColor background, GColor foreground);
+void status_bar_layer_set_separator_mode(StatusBarLayer *status_bar_layer, StatusBarLayerSeparatorMode mode);
+
+typedef struct GDrawCommandImage GDrawCommandImage;
+
+GDrawCommandImage *gdraw_command_image_create_with_resource(uint32_t resource_id);
+void gdraw_command_image_destroy(GDrawCommandImage *image);
+void gdraw_command_image_draw(GContext *ctx, GDrawCommandImage *image, GPoint offset);
+
+// Resources and fonts
+
+typedef void *ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle handle);
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle handle, uint32_t start_offset, uint8_t *buffer, size_t num_bytes);
+
+// Registers data as a resource. The stub doesn't copy it.
+void stub_add_resource(uint32_t resource_id, const void *data, size_t length);
+
+GFont fonts_get_system_font(const char *font_key);
+GFont fonts_load_custom_font(ResHandle handle);
+void fonts_unload_custom_font(GFont font);
+
+int stub_count_custom_fonts(void);
+
+#define FONT_KEY_GOTHIC_09 "RESOURCE_ID_GOTHIC_09"
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24 "RESOURCE_ID_GOTHIC_24"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28 "RESOURCE_ID_GOTHIC_28"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+#define FONT_KEY_BITHAM_30_BLACK "RESOURCE_ID_BITHAM_30_BLACK"
+#define FONT_KEY_BITHAM_42_BOLD "RESOURCE_ID_BITHAM_42_BOLD"
+#define FONT_KEY_BITHAM_42_LIGHT "RESOURCE_ID_BITHAM_42_LIGHT"
+#define FONT_KEY_BITHAM_42_MEDIUM_NUMBERS "RESOURCE_ID_BITHAM_42_MEDIUM_NUMBERS"
+#define FONT_KEY_BITHAM_34_MEDIUM_NUMBERS "RESOURCE_ID_BITHAM_34_MEDIUM_NUMBERS"
+#define FONT_KEY_BITHAM_34_LIGHT_SUBSET "RESOURCE_ID_BITHAM_34_LIGHT_SUBSET"
+#define FONT_KEY_BITHAM_18_LIGHT_SUBSET "RESOURCE_ID_BITHAM_18_LIGHT_SUBSET"
+#define FONT_KEY_ROBOTO_CONDENSED_21 "RESOURCE_ID_ROBOTO_CONDENSED_21"
+#define FONT_KEY_ROBOTO_BOLD_SUBSET_49 "RESOURCE_ID_ROBOTO_BOLD_SUBSET_49"
+#define FONT_KEY_DROID_SERIF_28_BOLD "RESOURCE_ID_DROID_SERIF_28_BOLD"
+#define FONT_KEY_LECO_20_BOLD_NUMBERS "RESOURCE_ID_LECO_20_BOLD_NUMBERS"
+#define FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM "RESOURCE_ID_LECO_26_BOLD_NUMBERS_AM_PM"
+#define FONT_KEY_LECO_28_LIGHT_NUMBERS "RESOURCE_ID_LECO_28_LIGHT_NUMBERS"
+#define FONT_KEY_LECO_32_BOLD_NUMBERS "RESOURCE_ID_LECO_32_BOLD_NUMBERS"
+#define FONT_KEY_LECO_36_BOLD_NUMBERS "RESOURCE_ID_LECO_36_BOLD_NUMBERS"
+#define FONT_KEY_LECO_38_BOLD_NUMBERS "RESOURCE_ID_LECO_38_BOLD_NUMBERS"
+#define FONT_KEY_LECO_42_NUMBERS "RESOURCE_ID_LECO_42_NUMBERS"
+
+// Timers
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+void app_timer_cancel(AppTimer *timer);
+
+// Runs the timers registered so far, as the event loop would.
+void stub_run_timers(void);
+
+// Platform: the stub builds as basalt.
+
+typedef enum {
+    PlatformTypeAplite,
+    PlatformTypeBasalt,
+    PlatformTypeChalk,
+    PlatformTypeDiorite,
+    PlatformTypeEmery
+} PlatformType;
+
+#define PBL_PLATFORM_BASALT
+#define PBL_COLOR
+#define PBL_RECT
+#define PBL_HEALTH
+#define PBL_MICROPHONE
+#define PBL_SMARTSTRAP
+#define PBL_DISPLAY_WIDTH 144
+#define PBL_DISPLAY_HEIGHT 168
+
+#define PBL_PLATFORM_TYPE_CURRENT PlatformTypeBasalt
+#define PBL_PLATFORM_SWITCH(platform, aplite, basalt, chalk, diorite, emery) (basalt)
+
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_HEALTH_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_MICROPHONE_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_SMARTSTRAP_ELSE(if_true, if_false) (if_true)
@@ -0,0 +1,48 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+#define RESOURCE_ID_ICON 1
+#define CYCLES 50
+
+static const char *LAYOUT =
+    "{\"id\": \"root\", \"layers\": ["
+    "  {\"id\": \"steps\", \"type\": \"TextLayer\", \"text\": \"{{steps}}\"},"
+    "  {\"id\": \"panel\", \"lazy\": true, \"layers\": ["
+    "    {\"id\": \"label\", \"type\": \"TextLayer\", \"text\": \"Steps: {{steps}}\"},"
+    "    {\"id\": \"icon\", \"type\": \"BitmapLayer\", \"bitmap\": \"icon\"},"
+    "    {\"id\": \"part\", \"type\": \"BitmapLayer\", \"bitmap\": \"icon\", \"source\": [0, 0, 8, 8]}"
+    "  ]}"
+    "]}";
+
+// One round of everything that allocates after parsing.
+static void prv_cycle(Layout *layout) {
+    CHECK(layout_materialize(layout, "label"));
+    layout_set_value(layout, "steps", "1234");
+    stub_run_timers();
+    layout_apply(layout, "{\"steps\": {\"text\": \"{{steps}}!\"}, \"label\": {\"text\": \"plain\"}}");
+    layout_dematerialize(layout, "panel");
+}
+
+int main(void) {
+    static const char icon[] = "icon";
+    stub_add_resource(RESOURCE_ID_ICON, icon, sizeof(icon));
+    size_t before = heap_bytes_used();
+
+    for (int arena = 0; arena < 2; arena++) {
+        Layout *layout = arena ? layout_create_with_arena(512) : layout_create();
+        layout_add_all_standard_types(layout);
+        layout_add_resource(layout, "icon", RESOURCE_ID_ICON);
+        layout_parse(layout, LAYOUT);
+
+        prv_cycle(layout);
+        size_t settled = heap_bytes_used();
+        for (int i = 0; i < CYCLES; i++) prv_cycle(layout);
+        CHECK(heap_bytes_used() == settled);
+        CHECK(stub_count_bitmaps() == 0);
+
+        layout_destroy(layout);
+        CHECK(heap_bytes_used() == before);
+    }
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+#define RESOURCE_ID_LAYOUT 1
+
+// {"id": "root", "layers": [{"id": "child"}]} as written by
+// tools/compile_layout.py, with "id" interned.
+static const uint8_t LAYOUT[] = {
+    'P', 'L', 'B', '2', 8, 0, 17, 0,
+    1, 0, 2, 0, 0, 0, 0, 0,     // object, 2 keys
+    3, 0, 1, 0, 0, 0, 2, 0,     // "id"
+    3, 0, 0, 0, 2, 0, 4, 0,     // "root"
+    3, 0, 1, 0, 6, 0, 6, 0,     // "layers"
+    2, 0, 1, 0, 0, 0, 0, 0,     // array, 1 item
+    1, 0, 1, 0, 0, 0, 0, 0,     // object, 1 key
+    3, 0, 1, 0, 0, 0, 2, 0,     // "id"
+    // The last token, "child", is below so tests can break it.
+};
+static const uint8_t LAST_TOKEN[] = {3, 0, 0, 0, 12, 0, 5, 0};
+static const char POOL[] = "idrootlayerschild";
+
+#define TOKEN_OBJECT 1
+#define TOKEN_ARRAY 2
+#define TOKEN_STRING 3
+#define TOKEN_PRIMITIVE 4
+#define FLAG_COLOR 0x10
+#define FLAG_TYPE 0x20
+#define FLAG_FRAME 0x40
+
+static uint8_t s_buffer[1024];
+
+// Longer layouts are written token by token, interning text the way the
+// compiler does.
+static uint8_t s_tokens[64 * 8];
+static uint16_t s_num_tokens;
+static uint8_t s_pool[256];
+static uint16_t s_pool_size;
+
+static uint16_t prv_intern(const void *data, size_t len) {
+    for (uint16_t i = 0; i + len <= s_pool_size; i++) {
+        if (memcmp(s_pool + i, data, len) == 0) return i;
+    }
+    CHECK(s_pool_size + len <= sizeof(s_pool));
+    memcpy(s_pool + s_pool_size, data, len);
+    s_pool_size += len;
+    return s_pool_size - len;
+}
+
+static void prv_token(uint8_t type, uint8_t value, uint16_t size, const void *data, size_t len) {
+    CHECK(s_num_tokens < sizeof(s_tokens) / 8);
+    uint16_t start = len > 0 ? prv_intern(data, len) : 0;
+    uint8_t *t = s_tokens + s_num_tokens++ * 8;
+    const uint8_t token[] = {type, value, size, size >> 8, start, start >> 8, len, len >> 8};
+    memcpy(t, token, sizeof(token));
+}
+
+static void prv_container(uint8_t type, uint16_t size) {
+    prv_token(type, 0, size, NULL, 0);
+}
+
+static void prv_text(uint8_t type, uint8_t value, const char *text) {
+    prv_token(type, value, 0, text, strlen(text));
+}
+
+static void prv_key(const char *key) {
+    prv_token(TOKEN_STRING, 0, 1, key, strlen(key));
+}
+
+static void prv_frame(int16_t x, int16_t y, int16_t w, int16_t h) {
+    const uint8_t record[] = {x, x >> 8, y, y >> 8, w, w >> 8, h, h >> 8};
+    prv_token(TOKEN_ARRAY | FLAG_FRAME, 0, 4, record, sizeof(record));
+    const int16_t values[] = {x, y, w, h};
+    for (int i = 0; i < 4; i++) {
+        char text[8];
+        snprintf(text, sizeof(text), "%d", values[i]);
+        prv_text(TOKEN_PRIMITIVE, 0, text);
+    }
+}
+
+static size_t prv_finish(void) {
+    const uint8_t header[] = {'P', 'L', 'B', '2', s_num_tokens, s_num_tokens >> 8, s_pool_size, s_pool_size >> 8};
+    size_t length = sizeof(header) + s_num_tokens * 8 + s_pool_size;
+    CHECK(length <= sizeof(s_buffer));
+    memcpy(s_buffer, header, sizeof(header));
+    memcpy(s_buffer + sizeof(header), s_tokens, s_num_tokens * 8);
+    memcpy(s_buffer + sizeof(header) + s_num_tokens * 8, s_pool, s_pool_size);
+    s_num_tokens = 0;
+    s_pool_size = 0;
+    return length;
+}
+
+static size_t prv_build(const uint8_t *last_token) {
+    memcpy(s_buffer, LAYOUT, sizeof(LAYOUT));
+    memcpy(s_buffer + sizeof(LAYOUT), last_token, sizeof(LAST_TOKEN));
+    memcpy(s_buffer + sizeof(LAYOUT) + sizeof(LAST_TOKEN), POOL, strlen(POOL));
+    return sizeof(LAYOUT) + sizeof(LAST_TOKEN) + strlen(POOL);
+}
+
+static Layout *prv_parse(size_t length) {
+    stub_add_resource(RESOURCE_ID_LAYOUT, s_buffer, length);
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_parse_binary_resource(layout, RESOURCE_ID_LAYOUT);
+    return layout;
+}
+
+// Types, frames and colors are read from their records. The records differ
+// from the text here so the test sees which is read. Strings are the raw
+// source text, as with JSON.
+static void prv_test_records(void) {
+    prv_container(TOKEN_OBJECT, 1);
+    prv_key("layers");
+    prv_container(TOKEN_ARRAY, 1);
+    prv_container(TOKEN_OBJECT, 5);
+    prv_key("id");
+    prv_text(TOKEN_STRING, 0, "t");
+    prv_key("type");
+    prv_text(TOKEN_STRING | FLAG_TYPE, 1, "Missing");
+    prv_key("frame");
+    const uint8_t record[] = {1, 0, 2, 0, 30, 0, 40, 0};
+    prv_token(TOKEN_ARRAY | FLAG_FRAME, 0, 4, record, sizeof(record));
+    for (int i = 0; i < 4; i++) prv_text(TOKEN_PRIMITIVE, 0, "0");
+    prv_key("color");
+    prv_text(TOKEN_STRING | FLAG_COLOR, GColorFromHEX(0xFF0000).argb, "#000000");
+    prv_key("text");
+    prv_text(TOKEN_STRING, 0, "a\\\"b");
+
+    Layout *layout = prv_parse(prv_finish());
+    TextLayer *t = layout_find_by_id(layout, "t");
+    CHECK(t);
+    GRect frame = layer_get_frame(text_layer_get_layer(t));
+    CHECK(frame.origin.x == 1 && frame.origin.y == 2 && frame.size.w == 30 && frame.size.h == 40);
+    CHECK(stub_text_layer_get_text_color(t).argb == GColorFromHEX(0xFF0000).argb);
+    CHECK(strcmp(text_layer_get_text(t), "a\\\"b") == 0);
+    layout_destroy(layout);
+
+    layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_parse(layout, "{\"layers\":[{\"id\":\"t\",\"type\":\"TextLayer\",\"text\":\"a\\\"b\"}]}");
+    CHECK(strcmp(text_layer_get_text(layout_find_by_id(layout, "t")), "a\\\"b") == 0);
+    layout_destroy(layout);
+
+    // Flags on tokens that can't hold them.
+    prv_text(TOKEN_PRIMITIVE | FLAG_COLOR, 0, "1");
+    layout = prv_parse(prv_finish());
+    CHECK(!layout_get_layer(layout));
+    layout_destroy(layout);
+    prv_text(TOKEN_STRING | FLAG_FRAME, 0, "12345678");
+    layout = prv_parse(prv_finish());
+    CHECK(!layout_get_layer(layout));
+    layout_destroy(layout);
+}
+
+static int s_rows_bound;
+
+static void prv_bind_row(Layout *row, uint16_t index, void *context) {
+    TextLayer *label = layout_find_by_id(row, "row");
+    if (label && strcmp(text_layer_get_text(label), "a\\nb") == 0) s_rows_bound++;
+}
+
+// RepeatLayer rows and lazy layers are rebuilt as JSON from the compiled
+// tokens, strings and all.
+static void prv_test_copied_trees(void) {
+    prv_container(TOKEN_OBJECT, 1);
+    prv_key("layers");
+    prv_container(TOKEN_ARRAY, 2);
+
+    prv_container(TOKEN_OBJECT, 4);
+    prv_key("id");
+    prv_text(TOKEN_STRING, 0, "list");
+    prv_key("type");
+    prv_text(TOKEN_STRING | FLAG_TYPE, 5, "RepeatLayer");
+    prv_key("frame");
+    prv_frame(0, 0, 144, 40);
+    prv_key("layers");
+    prv_container(TOKEN_ARRAY, 1);
+    prv_container(TOKEN_OBJECT, 2);
+    prv_key("frame");
+    prv_frame(0, 0, 144, 20);
+    prv_key("layers");
+    prv_container(TOKEN_ARRAY, 1);
+    prv_container(TOKEN_OBJECT, 3);
+    prv_key("id");
+    prv_text(TOKEN_STRING, 0, "row");
+    prv_key("type");
+    prv_text(TOKEN_STRING | FLAG_TYPE, 1, "TextLayer");
+    prv_key("text");
+    prv_text(TOKEN_STRING, 0, "a\\nb");
+
+    prv_container(TOKEN_OBJECT, 3);
+    prv_key("id");
+    prv_text(TOKEN_STRING, 0, "more");
+    prv_key("lazy");
+    prv_text(TOKEN_PRIMITIVE, 0, "true");
+    prv_key("layers");
+    prv_container(TOKEN_ARRAY, 1);
+    prv_container(TOKEN_OBJECT, 4);
+    prv_key("id");
+    prv_text(TOKEN_STRING, 0, "inner");
+    prv_key("type");
+    prv_text(TOKEN_STRING | FLAG_TYPE, 1, "TextLayer");
+    prv_key("color");
+    prv_text(TOKEN_STRING | FLAG_COLOR, GColorFromHEX(0xFF0000).argb, "#FF0000");
+    prv_key("text");
+    prv_text(TOKEN_STRING, 0, "a\\nb");
+
+    Layout *layout = prv_parse(prv_finish());
+    repeat_layer_set_data(layout_find_by_id(layout, "list"), 3, prv_bind_row, NULL);
+    CHECK(s_rows_bound == 3);
+
+    Layer *root = layout_get_layer(layout);
+    CHECK(stub_layer_count_children(root) == 2);
+    TextLayer *inner = layout_find_by_id(layout, "inner");
+    CHECK(stub_layer_count_children(root) == 3);
+    CHECK(inner && strcmp(text_layer_get_text(inner), "a\\nb") == 0);
+    CHECK(stub_text_layer_get_text_color(inner).argb == GColorFromHEX(0xFF0000).argb);
+    layout_destroy(layout);
+}
+
+int main(void) {
+    size_t before = heap_bytes_used();
+    size_t length = prv_build(LAST_TOKEN);
+
+    Layout *layout = prv_parse(length);
+    CHECK(layout_find_by_id(layout, "root") == layout_get_layer(layout));
+    CHECK(layout_find_by_id(layout, "child"));
+    layout_destroy(layout);
+
+    // Every truncation fails to load.
+    for (size_t i = 0; i < length; i++) {
+        layout = prv_parse(i);
+        CHECK(!layout_get_layer(layout));
+        layout_destroy(layout);
+    }
+
+    // A token past the end of the pool.
+    const uint8_t past_pool[] = {3, 0, 0, 0, 12, 0, 6, 0};
+    length = prv_build(past_pool);
+    layout = prv_parse(length);
+    CHECK(!layout_get_layer(layout));
+    layout_destroy(layout);
+
+    // A container with more children than there are tokens.
+    const uint8_t too_many[] = {2, 0, 3, 0, 0, 0, 0, 0};
+    length = prv_build(too_many);
+    layout = prv_parse(length);
+    CHECK(!layout_get_layer(layout));
+    layout_destroy(layout);
+
+    prv_test_records();
+    prv_test_copied_trees();
+    CHECK(heap_bytes_used() == before);
+    return 0;
+}
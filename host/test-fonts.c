@@ -0,0 +1,47 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+#define RESOURCE_ID_DIGITS 1
+
+static const char *LAYOUT =
+    "{\"layers\": ["
+    "  {\"id\": \"time\", \"type\": \"TextLayer\", \"text\": \"12:00\", \"font\": \"DIGITS\"},"
+    "  {\"id\": \"date\", \"type\": \"TextLayer\", \"text\": \"Mon\", \"font\": \"GOTHIC_18\"}"
+    "]}";
+
+static Layout *prv_create(void) {
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_add_font(layout, "DIGITS", RESOURCE_ID_DIGITS);
+    return layout;
+}
+
+int main(void) {
+    static const char digits[] = "digits";
+    stub_add_resource(RESOURCE_ID_DIGITS, digits, sizeof(digits));
+
+    size_t before = heap_bytes_used();
+    Layout *first = prv_create();
+    Layout *second = prv_create();
+    // Adding a font doesn't load it.
+    CHECK(stub_count_custom_fonts() == 0);
+
+    layout_parse(first, LAYOUT);
+    CHECK(stub_count_custom_fonts() == 1);
+    layout_parse(second, LAYOUT);
+    CHECK(stub_count_custom_fonts() == 1);
+
+    GFont font = stub_text_layer_get_font(layout_find_by_id(first, "time"));
+    CHECK(font);
+    CHECK(stub_text_layer_get_font(layout_find_by_id(second, "time")) == font);
+    CHECK(stub_text_layer_get_font(layout_find_by_id(first, "date")) == fonts_get_system_font(FONT_KEY_GOTHIC_18));
+
+    layout_destroy(first);
+    CHECK(stub_count_custom_fonts() == 1);
+    layout_destroy(second);
+    CHECK(stub_count_custom_fonts() == 0);
+
+    CHECK(heap_bytes_used() == before);
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+typedef struct {
+    int min;
+    int max;
+    int value;
+} Gauge;
+
+static Layer *prv_gauge_create(GRect frame) {
+    Layer *layer = layer_create_with_data(frame, sizeof(Gauge));
+    memset(layer_get_data(layer), 0, sizeof(Gauge));
+    return layer;
+}
+
+static void prv_gauge_destroy(void *object) {
+    layer_destroy(object);
+}
+
+static Layer *prv_gauge_get_layer(void *object) {
+    return object;
+}
+
+// Indexes a nested object and returns without going back to the layer.
+static void prv_gauge_parse(Layout *layout, Json *json, void *object) {
+    Gauge *gauge = layer_get_data(object);
+    JsonMark node = json_mark(json);
+
+    if (json_seek(json, "range")) {
+        json_advance(json);
+        json_index(json);
+        if (json_seek(json, "min")) gauge->min = json_next_int(json);
+        if (json_seek(json, "max")) gauge->max = json_next_int(json);
+        CHECK(!json_seek(json, "value"));
+    }
+    json_reset(json, node);
+    if (json_seek(json, "value")) gauge->value = json_next_int(json);
+    json_reset(json, node);
+
+    if (json_seek(json, "range")) {
+        json_advance(json);
+        json_index(json);
+    }
+}
+
+static const char *LAYOUT =
+    "{\"id\": \"root\", \"layers\": ["
+    "  {\"id\": \"gauge\", \"type\": \"Gauge\", \"hidden\": true, \"value\": 3,"
+    "   \"range\": {\"min\": 1, \"max\": 9, \"id\": \"inner\"},"
+    "   \"layers\": [{\"id\": \"kid\", \"layers\": [{\"layers\": [{\"layers\": [{\"id\": \"deep\"}]}]}]}]},"
+    "  {\"id\": \"after\"}"
+    "]}";
+
+static void prv_check(Layout *layout) {
+    Layer *gauge = layout_find_by_id(layout, "gauge");
+    CHECK(gauge);
+    CHECK(layer_get_hidden(gauge));
+    Gauge *data = layer_get_data(gauge);
+    CHECK(data->min == 1 && data->max == 9 && data->value == 3);
+    CHECK(!layout_find_by_id(layout, "inner"));
+    Layer *kid = layout_find_by_id(layout, "kid");
+    CHECK(kid && stub_layer_get_parent(kid) == gauge);
+    // Deep enough for the stack of key indexes to grow.
+    CHECK(layout_find_by_id(layout, "deep"));
+    CHECK(layout_find_by_id(layout, "after"));
+}
+
+static void prv_check_accessors(void) {
+    Json *json = json_create(
+        "[true, \"yes\", 42, \"4x\", \"#00FF00\", \"0000FF\", \"#FF00\", \"#FFF\", \"0x00FF\", \"+0FFFF\"]", false);
+    bool b = false;
+    int i = 0;
+    GColor color;
+
+    CHECK(json_try_next_bool(json, &b) && b);
+    CHECK(!json_try_next_bool(json, &b));
+    CHECK(json_try_next_int(json, &i) && i == 42);
+    CHECK(!json_try_next_int(json, &i));
+    CHECK(json_try_next_color(json, &color) && color.argb == GColorFromHEX(0x00FF00).argb);
+    CHECK(json_try_next_color(json, &color) && color.argb == GColorFromHEX(0x0000FF).argb);
+    // Anything but six hex digits is an error, not some other color.
+    CHECK(!json_try_next_color(json, &color));
+    CHECK(!json_try_next_color(json, &color));
+    CHECK(!json_try_next_color(json, &color));
+    CHECK(!json_try_next_color(json, &color));
+    json_destroy(json);
+}
+
+int main(void) {
+    size_t before = heap_bytes_used();
+    prv_check_accessors();
+
+    TypeFuncs gauge = {
+        .create = (TypeCreateFunc) prv_gauge_create,
+        .destroy = prv_gauge_destroy,
+        .parse = prv_gauge_parse,
+        .get_layer = prv_gauge_get_layer,
+    };
+
+    Layout *layout = layout_create();
+    layout_add_type(layout, "Gauge", gauge, NULL);
+    layout_parse(layout, LAYOUT);
+    prv_check(layout);
+
+    LayoutTemplate *layout_template = layout_template_create(layout, LAYOUT);
+    for (int i = 0; i < 3; i++) {
+        Layout *instance = layout_create_from_template(layout_template, NULL);
+        prv_check(instance);
+        layout_destroy(instance);
+    }
+    layout_template_destroy(layout_template);
+    layout_destroy(layout);
+
+    CHECK(heap_bytes_used() == before);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "keywords.h"
+#include "check.h"
+
+static const struct {
+    const char *name;
+    Keyword keyword;
+} KEYWORDS[] = {
+    { "left", KEYWORD_LEFT },
+    { "GTextAlignmentLeft", KEYWORD_LEFT },
+    { "GAlignLeft", KEYWORD_LEFT },
+    { "center", KEYWORD_CENTER },
+    { "GTextAlignmentCenter", KEYWORD_CENTER },
+    { "GAlignCenter", KEYWORD_CENTER },
+    { "right", KEYWORD_RIGHT },
+    { "GTextAlignmentRight", KEYWORD_RIGHT },
+    { "GAlignRight", KEYWORD_RIGHT },
+    { "top-left", KEYWORD_TOP_LEFT },
+    { "GAlignTopLeft", KEYWORD_TOP_LEFT },
+    { "top", KEYWORD_TOP },
+    { "GAlignTop", KEYWORD_TOP },
+    { "top-right", KEYWORD_TOP_RIGHT },
+    { "GAlignTopRight", KEYWORD_TOP_RIGHT },
+    { "bottom-left", KEYWORD_BOTTOM_LEFT },
+    { "GAlignBottomLeft", KEYWORD_BOTTOM_LEFT },
+    { "bottom", KEYWORD_BOTTOM },
+    { "GAlignBottom", KEYWORD_BOTTOM },
+    { "bottom-right", KEYWORD_BOTTOM_RIGHT },
+    { "GAlignBottomRight", KEYWORD_BOTTOM_RIGHT },
+    { "assign", KEYWORD_ASSIGN },
+    { "GCompOpAssign", KEYWORD_ASSIGN },
+    { "inverted", KEYWORD_INVERTED },
+    { "GCompOpAssignInverted", KEYWORD_INVERTED },
+    { "or", KEYWORD_OR },
+    { "GCompOpOr", KEYWORD_OR },
+    { "and", KEYWORD_AND },
+    { "GCompOpAnd", KEYWORD_AND },
+    { "clear", KEYWORD_CLEAR },
+    { "GCompOpClear", KEYWORD_CLEAR },
+    { "set", KEYWORD_SET },
+    { "GCompOpSet", KEYWORD_SET },
+    { "none", KEYWORD_NONE },
+    { "StatusBarLayerSeparatorModeNone", KEYWORD_NONE },
+    { "dotted", KEYWORD_DOTTED },
+    { "StatusBarLayerSeparatorModeDotted", KEYWORD_DOTTED },
+    { "PLATFORM_APLITE", KEYWORD_PLATFORM_APLITE },
+    { "PLATFORM_BASALT", KEYWORD_PLATFORM_BASALT },
+    { "PLATFORM_CHALK", KEYWORD_PLATFORM_CHALK },
+    { "PLATFORM_DIORITE", KEYWORD_PLATFORM_DIORITE },
+    { "BW", KEYWORD_BW },
+    { "COLOR", KEYWORD_COLOR },
+    { "HEALTH", KEYWORD_HEALTH },
+    { "RECT", KEYWORD_RECT },
+    { "ROUND", KEYWORD_ROUND },
+    { "MICROPHONE", KEYWORD_MICROPHONE },
+    { "SMARTSTRAP", KEYWORD_SMARTSTRAP },
+};
+
+static Keyword prv_lookup(const char *s, size_t len) {
+    return keyword_lookup((JsonString) { .str = s, .len = len });
+}
+
+int main(void) {
+    for (size_t i = 0; i < ARRAY_LENGTH(KEYWORDS); i++) {
+        const char *name = KEYWORDS[i].name;
+        CHECK(prv_lookup(name, strlen(name)) == KEYWORDS[i].keyword);
+        // A prefix of a name is not the name.
+        CHECK(prv_lookup(name, strlen(name) - 1) != KEYWORDS[i].keyword);
+    }
+
+    // Names are views into the source, so only len characters count.
+    CHECK(prv_lookup("left\", \"top", 4) == KEYWORD_LEFT);
+    CHECK(prv_lookup("lefty", 5) == KEYWORD_UNKNOWN);
+    CHECK(prv_lookup("Left", 4) == KEYWORD_UNKNOWN);
+    CHECK(prv_lookup("", 0) == KEYWORD_UNKNOWN);
+    CHECK(prv_lookup(NULL, 0) == KEYWORD_UNKNOWN);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+#define RESOURCE_ID_ICON 1
+#define RESOURCE_ID_LAYOUT 2
+
+static const char *LAYOUT =
+    "{\"id\": \"root\", \"background\": \"#000000\", \"layers\": ["
+    "  {\"frame\": [20, 10, 124, 128], \"capabilities\": [\"NOT_ROUND\"], \"layers\": ["
+    "    {\"id\": \"title\", \"type\": \"TextLayer\", \"frame\": {\"x\": 1, \"y\": 2, \"w\": 3, \"h\": 4},"
+    "     \"text\": \"Hello\", \"color\": \"#FFFFFF\", \"alignment\": \"center\", \"font\": \"GOTHIC_28_BOLD\"}]},"
+    "  {\"id\": \"round\", \"capabilities\": [\"ROUND\"], \"layers\": [{\"id\": \"round_child\"}]},"
+    "  {\"id\": \"unknown\", \"type\": \"NoSuchLayer\"},"
+    "  {\"id\": \"icon\", \"type\": \"BitmapLayer\", \"bitmap\": \"icon\", \"frame\": [0, 0, 10, 10]},"
+    "  {\"id\": \"status\", \"type\": \"StatusBarLayer\", \"hidden\": true},"
+    "  {\"id\": \"footer\", \"frame\": [0, 120, 144, 40], \"clips\": false}"
+    "]}";
+
+typedef enum {
+    ParseString,
+    ParseResource,
+    ParseStreaming,
+    ParseModeCount
+} ParseMode;
+
+static void prv_check_layout(Layout *layout) {
+    Layer *root = layout_get_layer(layout);
+    CHECK(root);
+    CHECK(layout_find_by_id(layout, "root") == root);
+
+    TextLayer *title = layout_find_by_id(layout, "title");
+    CHECK(title);
+    CHECK(strcmp(text_layer_get_text(title), "Hello") == 0);
+    GRect frame = layer_get_frame(text_layer_get_layer(title));
+    CHECK(frame.origin.x == 1 && frame.origin.y == 2 && frame.size.w == 3 && frame.size.h == 4);
+    CHECK(stub_text_layer_get_alignment(title) == GTextAlignmentCenter);
+    CHECK(stub_text_layer_get_text_color(title).argb == GColorWhite.argb);
+    CHECK(stub_text_layer_get_font(title) == fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD));
+
+    CHECK(!layout_find_by_id(layout, "round"));
+    CHECK(!layout_find_by_id(layout, "round_child"));
+    CHECK(!layout_find_by_id(layout, "unknown"));
+
+    BitmapLayer *icon = layout_find_by_id(layout, "icon");
+    CHECK(icon && bitmap_layer_get_bitmap(icon));
+
+    StatusBarLayer *status = layout_find_by_id(layout, "status");
+    CHECK(status && layer_get_hidden(status_bar_layer_get_layer(status)));
+
+    Layer *footer = layout_find_by_id(layout, "footer");
+    CHECK(footer && !layer_get_clips(footer));
+    CHECK(stub_layer_get_parent(footer) == root);
+}
+
+int main(void) {
+    static const char icon[] = "icon";
+    stub_add_resource(RESOURCE_ID_ICON, icon, sizeof(icon));
+    stub_add_resource(RESOURCE_ID_LAYOUT, LAYOUT, strlen(LAYOUT));
+
+    size_t before = heap_bytes_used();
+    for (int arena = 0; arena < 2; arena++) {
+        for (ParseMode mode = 0; mode < ParseModeCount; mode++) {
+            Layout *layout = arena ? layout_create_with_arena(1024) : layout_create();
+            layout_add_all_standard_types(layout);
+            layout_add_resource(layout, "icon", RESOURCE_ID_ICON);
+            size_t parsing = heap_bytes_used();
+            switch (mode) {
+                case ParseString: layout_parse(layout, LAYOUT); break;
+                case ParseResource: layout_parse_resource(layout, RESOURCE_ID_LAYOUT); break;
+                default: layout_parse_resource_streaming(layout, RESOURCE_ID_LAYOUT); break;
+            }
+            prv_check_layout(layout);
+            // The peak includes the JSON and tokens freed since.
+            LayoutStats stats;
+            layout_get_stats(layout, &stats);
+            CHECK(stats.parse_peak > heap_bytes_used() - parsing);
+            layout_destroy(layout);
+            CHECK(stub_count_bitmaps() == 0);
+            CHECK(heap_bytes_used() == before);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+static const char *LAYOUT =
+    "{\"id\": \"root\", \"layers\": ["
+    "  {\"id\": \"panel\", \"lazy\": true, \"layers\": ["
+    "    {\"id\": \"label\", \"type\": \"TextLayer\", \"text\": \"hi\"},"
+    "    {\"id\": \"round\", \"capabilities\": [\"ROUND\"], \"layers\": [{\"id\": \"round_child\"}]},"
+    "    {\"id\": \"unknown\", \"type\": \"NoSuchLayer\", \"layers\": [{\"id\": \"unknown_child\"}]},"
+    "    {\"id\": \"list\", \"type\": \"RepeatLayer\", \"frame\": [0, 0, 144, 40], \"layers\": ["
+    "      {\"frame\": [0, 0, 144, 20], \"layers\": [{\"id\": \"row_title\"}]}"
+    "    ]}"
+    "  ]}"
+    "]}";
+
+int main(void) {
+    size_t before = heap_bytes_used();
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_parse(layout, LAYOUT);
+    Layer *root = layout_get_layer(layout);
+    CHECK(stub_layer_count_children(root) == 1);
+
+    // IDs the lazy layer would never create don't build it.
+    const char *missing[] = {"round", "round_child", "unknown", "unknown_child", "row_title"};
+    for (size_t i = 0; i < ARRAY_LENGTH(missing); i++) {
+        CHECK(!layout_find_by_id(layout, missing[i]));
+        CHECK(stub_layer_count_children(root) == 1);
+    }
+
+    CHECK(layout_find_by_id(layout, "list"));
+    CHECK(stub_layer_count_children(root) == 2);
+    CHECK(layout_find_by_id(layout, "label"));
+    layout_dematerialize(layout, "panel");
+    CHECK(stub_layer_count_children(root) == 1);
+
+    layout_destroy(layout);
+    CHECK(heap_bytes_used() == before);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+// Four levels deep, so children phases nest inside each other.
+static const char *LAYOUT =
+    "{\"id\": \"root\", \"layers\": ["
+    "  {\"layers\": [{\"layers\": [{\"layers\": [{\"type\": \"TextLayer\", \"text\": \"deep\"}]}]}]},"
+    "  {\"type\": \"TextLayer\", \"text\": \"shallow\"}"
+    "]}";
+
+static uint32_t prv_now(void) {
+    time_t s;
+    uint16_t ms = time_ms(&s, NULL);
+    return (uint32_t) s * 1000 + ms;
+}
+
+int main(void) {
+    stub_set_clock_step(1);
+    layout_profile_reset();
+
+    uint32_t start = prv_now();
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_parse(layout, LAYOUT);
+    uint32_t elapsed = prv_now() - start;
+    layout_destroy(layout);
+
+    // Each phase counts only its own time, so together they can't take
+    // longer than the parse did.
+    uint32_t total = 0;
+    for (LayoutPhase phase = 0; phase < LayoutPhaseCount; phase++) total += layout_profile_get(phase).ms;
+    CHECK(total > 0 && total <= elapsed);
+    CHECK(layout_profile_get(LayoutPhaseCapabilities).calls == 6);
+    CHECK(layout_profile_get(LayoutPhaseChildren).calls == 4);
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+#define RESOURCE_ID_LAYOUT 1
+
+static Layout *prv_parse_streaming(const char *s) {
+    stub_add_resource(RESOURCE_ID_LAYOUT, s, strlen(s));
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_parse_resource_streaming(layout, RESOURCE_ID_LAYOUT);
+    return layout;
+}
+
+// Resources that end early fail to parse rather than looping on the window.
+static void prv_test_truncated(void) {
+    const char *truncated[] = {
+        "{\"id\":\"root\",\"layers\":[{\"id\":\"x\",\"text\":\"unterminated",
+        "{\"id\":\"root\",\"layers\":[{\"id\":\"x\"}",
+        "{\"id\":\"root\",\"layers\":[{\"id\":\"x\",\"frame\":[1,2",
+        "{\"id\":\"",
+        // Errors in layers that aren't tokenized until they're built.
+        "{\"layers\":[{\"layers\":[{\"id\":\"x\"]}]}",
+        "{\"layers\":[{\"layers\":[{\"id\":\"\\q\"}]}]}",
+    };
+    for (size_t i = 0; i < ARRAY_LENGTH(truncated); i++) {
+        Layout *layout = prv_parse_streaming(truncated[i]);
+        CHECK(!layout_get_layer(layout));
+        layout_destroy(layout);
+    }
+}
+
+// A string longer than the window grows it.
+static void prv_test_long_string(void) {
+    size_t len = 1000;
+    char *s = malloc(len + 64);
+    char *text = malloc(len + 1);
+    memset(text, 'a', len);
+    text[len] = '\0';
+    snprintf(s, len + 64, "{\"layers\":[{\"id\":\"x\",\"type\":\"TextLayer\",\"text\":\"%s\"}]}", text);
+    Layout *layout = prv_parse_streaming(s);
+    TextLayer *x = layout_find_by_id(layout, "x");
+    CHECK(x && strcmp(text_layer_get_text(x), text) == 0);
+    layout_destroy(layout);
+    free(text);
+    free(s);
+}
+
+// A token too long for the largest window fails rather than wrapping the
+// window size around.
+static void prv_test_huge_string(void) {
+    size_t len = 70000;
+    char *s = malloc(len + 64);
+    strcpy(s, "{\"id\":\"");
+    memset(s + strlen(s), 'a', len);
+    strcpy(s + 7 + len, "\"}");
+    Layout *layout = prv_parse_streaming(s);
+    CHECK(!layout_get_layer(layout));
+    layout_destroy(layout);
+    free(s);
+}
+
+static int s_rows_bound;
+
+static void prv_bind_row(Layout *row, uint16_t index, void *context) {
+    if (layout_find_by_id(row, "row")) s_rows_bound++;
+}
+
+// RepeatLayer copies its row from the resource like a lazy layer does.
+static void prv_test_repeat(void) {
+    Layout *layout = prv_parse_streaming(
+        "{\"layers\":[{\"id\":\"list\",\"type\":\"RepeatLayer\",\"frame\":[0,0,144,40],\"layers\":["
+        "{\"frame\":[0,0,144,20],\"layers\":[{\"id\":\"row\",\"type\":\"TextLayer\"}]}]}]}");
+    repeat_layer_set_data(layout_find_by_id(layout, "list"), 3, prv_bind_row, NULL);
+    CHECK(s_rows_bound == 3);
+    layout_destroy(layout);
+}
+
+// Only the layers being built are tokenized, so streaming holds far less
+// than loading the whole file, and builds the same layers.
+static void prv_test_peak(void) {
+    size_t size = 64 * 1024;
+    char *s = malloc(size);
+    size_t len = snprintf(s, size, "{\"id\":\"root\",\"layers\":[");
+    for (int i = 0; i < 100; i++) {
+        len += snprintf(s + len, size - len, "%s{\"id\":\"row%d\",\"frame\":[0,%d,144,20],\"layers\":["
+                        "{\"id\":\"label%d\",\"type\":\"TextLayer\",\"text\":\"Row %d\",\"alignment\":\"center\"},"
+                        "{\"layers\":[{\"id\":\"dot%d\",\"lazy\":true,\"layers\":[{\"id\":\"inner%d\"}]}]}]}",
+                        i ? "," : "", i, i * 20, i, i, i, i);
+    }
+    len += snprintf(s + len, size - len, "]}");
+    CHECK(len < size);
+    stub_add_resource(RESOURCE_ID_LAYOUT, s, len);
+
+    size_t transient[2];
+    for (int streaming = 0; streaming < 2; streaming++) {
+        Layout *layout = layout_create();
+        layout_add_all_standard_types(layout);
+        size_t parsing = heap_bytes_used();
+        if (streaming) layout_parse_resource_streaming(layout, RESOURCE_ID_LAYOUT);
+        else layout_parse_resource(layout, RESOURCE_ID_LAYOUT);
+
+        LayoutStats stats;
+        layout_get_stats(layout, &stats);
+        transient[streaming] = stats.parse_peak - (heap_bytes_used() - parsing);
+        TextLayer *label = layout_find_by_id(layout, "label99");
+        CHECK(label && strcmp(text_layer_get_text(label), "Row 99") == 0);
+        CHECK(layer_get_frame(layout_find_by_id(layout, "row42")).origin.y == 42 * 20);
+        CHECK(layout_find_by_id(layout, "inner7"));
+        layout_destroy(layout);
+    }
+    CHECK(transient[1] * 5 < transient[0]);
+    free(s);
+}
+
+int main(void) {
+    size_t before = heap_bytes_used();
+    prv_test_truncated();
+    prv_test_long_string();
+    prv_test_huge_string();
+    prv_test_repeat();
+    prv_test_peak();
+    CHECK(heap_bytes_used() == before);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+#define RESOURCE_ID_ICON 1
+#define NUM_ROWS 3
+
+static const char *ROW =
+    "{\"id\": \"row\", \"frame\": [0, 0, 144, 40], \"layers\": ["
+    "  {\"id\": \"title\", \"type\": \"TextLayer\", \"frame\": [0, 0, 100, 20], \"text\": \"Title\","
+    "   \"color\": \"#FFFFFF\", \"alignment\": \"right\", \"font\": \"GOTHIC_18_BOLD\"},"
+    "  {\"id\": \"steps\", \"type\": \"TextLayer\", \"text\": \"{{steps}} steps\"},"
+    "  {\"id\": \"icon\", \"type\": \"BitmapLayer\", \"bitmap\": \"icon\", \"hidden\": true},"
+    "  {\"id\": \"counter\", \"type\": \"Counter\", \"start\": 3}"
+    "]}";
+
+static int s_counter_parses;
+
+static void *prv_counter_create(GRect frame) {
+    return layer_create(frame);
+}
+
+static void prv_counter_parse(Layout *layout, Json *json, void *object) {
+    if (json_seek(json, "start") && json_next_int(json) == 3) s_counter_parses++;
+}
+
+int main(void) {
+    static const char icon[] = "icon";
+    stub_add_resource(RESOURCE_ID_ICON, icon, sizeof(icon));
+
+    size_t before = heap_bytes_used();
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_add_resource(layout, "icon", RESOURCE_ID_ICON);
+    layout_add_type(layout, "Counter", (TypeFuncs) {
+        .create = prv_counter_create,
+        .destroy = (TypeDestroyFunc) layer_destroy,
+        .parse = prv_counter_parse
+    }, NULL);
+
+    LayoutTemplate *row = layout_template_create(layout, ROW);
+    Layout *rows[NUM_ROWS];
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i] = layout_create_from_template(row, i == 0 ? "{\"title\": {\"text\": \"First\"}}" : NULL);
+    }
+    layout_template_destroy(row);
+
+    // Custom types still parse their JSON for every row.
+    CHECK(s_counter_parses == NUM_ROWS);
+
+    for (int i = 0; i < NUM_ROWS; i++) {
+        TextLayer *title = layout_find_by_id(rows[i], "title");
+        CHECK(strcmp(text_layer_get_text(title), i == 0 ? "First" : "Title") == 0);
+        CHECK(stub_text_layer_get_text_color(title).argb == GColorWhite.argb);
+        CHECK(stub_text_layer_get_alignment(title) == GTextAlignmentRight);
+        CHECK(stub_text_layer_get_font(title) == fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD));
+        GRect frame = layer_get_frame(text_layer_get_layer(title));
+        CHECK(frame.size.w == 100 && frame.size.h == 20);
+
+        TextLayer *steps = layout_find_by_id(rows[i], "steps");
+        CHECK(strcmp(text_layer_get_text(steps), " steps") == 0);
+        layout_set_value(rows[i], "steps", "42");
+
+        BitmapLayer *bitmap = layout_find_by_id(rows[i], "icon");
+        CHECK(bitmap_layer_get_bitmap(bitmap));
+        CHECK(layer_get_hidden(bitmap_layer_get_layer(bitmap)));
+        CHECK(!layer_get_hidden(text_layer_get_layer(title)));
+    }
+    stub_run_timers();
+    CHECK(strcmp(text_layer_get_text(layout_find_by_id(rows[1], "steps")), "42 steps") == 0);
+
+    // Every row shows the bitmap the layout loaded once.
+    CHECK(stub_count_bitmaps() == 1);
+    CHECK(bitmap_layer_get_bitmap(layout_find_by_id(rows[0], "icon")) ==
+          bitmap_layer_get_bitmap(layout_find_by_id(rows[2], "icon")));
+
+    for (int i = 0; i < NUM_ROWS; i++) {
+        layout_destroy(rows[i]);
+        CHECK(stub_count_bitmaps() == (i < NUM_ROWS - 1 ? 1 : 0));
+    }
+    layout_destroy(layout);
+    CHECK(heap_bytes_used() == before);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <pebble.h>
+#include <pebble-layout.h>
+#include "check.h"
+
+static const char *ITEMS[] = {"one", "two", "three", "four", "five", "six"};
+
+static const char *LAYOUT =
+    "{\"layers\": ["
+    "  {\"id\": \"title\", \"type\": \"TextLayer\", \"text\": \"parsed\"},"
+    "  {\"id\": \"steps\", \"type\": \"TextLayer\", \"text\": \"Steps: {{steps}}\"},"
+    "  {\"id\": \"label\", \"type\": \"Label\", \"text\": \"label\"},"
+    "  {\"id\": \"list\", \"type\": \"RepeatLayer\", \"frame\": [0, 0, 144, 60], \"layers\": ["
+    "    {\"frame\": [0, 0, 144, 20], \"layers\": [{\"id\": \"row\", \"type\": \"TextLayer\", \"text\": \"-\"}]}"
+    "  ]}"
+    "]}";
+
+// A custom type built on TextLayer, with its own create.
+static void *prv_label_create(GRect frame) {
+    return text_layer_create(frame);
+}
+
+static void *prv_label_cast(void *object) {
+    return object;
+}
+
+static void prv_bind_row(Layout *row, uint16_t index, void *context) {
+    text_layer_set_text(layout_find_by_id(row, "row"), ITEMS[index]);
+}
+
+int main(void) {
+    size_t before = heap_bytes_used();
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_add_type(layout, "Label", (TypeFuncs) {
+        .create = prv_label_create,
+        .destroy = (TypeDestroyFunc) text_layer_destroy,
+        .get_layer = (TypeGetLayerFunc) text_layer_get_layer,
+        .cast = prv_label_cast
+    }, "TextLayer");
+    layout_parse(layout, LAYOUT);
+
+    // Text layers default to a clear background, custom ones too, and a
+    // patch that doesn't mention it leaves the app's color alone.
+    TextLayer *label = layout_find_by_id(layout, "label");
+    CHECK(gcolor_equal(stub_text_layer_get_background_color(label), GColorClear));
+    text_layer_set_background_color(label, GColorBlack);
+    layout_apply(layout, "{\"label\": {\"text\": \"patched\"}}");
+    CHECK(gcolor_equal(stub_text_layer_get_background_color(label), GColorBlack));
+    CHECK(gcolor_equal(stub_text_layer_get_background_color(layout_find_by_id(layout, "title")), GColorClear));
+
+    // The app's own text is left alone, after parsing and after a patch.
+    TextLayer *title = layout_find_by_id(layout, "title");
+    CHECK(strcmp(text_layer_get_text(title), "parsed") == 0);
+    text_layer_set_text(title, ITEMS[0]);
+    layout_apply(layout, "{\"title\": {\"text\": \"patched\"}}");
+    CHECK(strcmp(text_layer_get_text(title), "patched") == 0);
+    text_layer_set_text(title, ITEMS[1]);
+
+    // Bound text renders into the binding's buffer, even if the app has
+    // set the layer's text since.
+    TextLayer *steps = layout_find_by_id(layout, "steps");
+    CHECK(strcmp(text_layer_get_text(steps), "Steps: ") == 0);
+    text_layer_set_text(steps, ITEMS[2]);
+    layout_set_value(layout, "steps", "1234");
+    stub_run_timers();
+    CHECK(strcmp(text_layer_get_text(steps), "Steps: 1234") == 0);
+    CHECK(strcmp(ITEMS[2], "three") == 0);
+
+    RepeatLayer *list = layout_find_by_id(layout, "list");
+    repeat_layer_set_data(list, ARRAY_LENGTH(ITEMS), prv_bind_row, NULL);
+    repeat_layer_set_offset(list, 40);
+
+    LayoutStats stats;
+    layout_get_stats(layout, &stats);
+    CHECK(stats.text == strlen("patched") + 1 + strlen("Steps: 1234") + 1 + strlen("patched") + 1);
+
+    layout_destroy(layout);
+    CHECK(heap_bytes_used() == before);
+    return 0;
+}
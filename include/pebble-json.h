@@ -2,11 +2,23 @@
 #include <pebble.h>
 
 typedef struct Json Json;
-typedef struct JsonMark JsonMark;
+
+typedef struct {
+    int16_t index;
+    int16_t depth;
+} JsonMark;
+
+typedef struct {
+    const char *str;
+    size_t len;
+} JsonString;
 
 Json *json_create_with_resource(uint32_t resource_id);
+Json *json_create_with_binary_resource(uint32_t resource_id);
+Json *json_create_with_resource_streaming(uint32_t resource_id);
 Json *json_create(const char *s, bool free_on_destroy);
 void json_destroy(Json *json);
+void json_get_memory(Json *json, size_t *text, size_t *tokens);
 
 bool json_is_string(Json *json);
 bool json_is_primitive(Json *json);
@@ -15,13 +27,23 @@ bool json_is_object(Json *json);
 
 bool json_has_next(Json *json);
 char *json_next_string(Json *json);
+JsonString json_next_string_view(Json *json);
 bool json_next_bool(Json *json);
 int json_next_int(Json *json);
 GColor json_next_color(Json *json);
+bool json_try_next_bool(Json *json, bool *value);
+bool json_try_next_int(Json *json, int *value);
+bool json_try_next_color(Json *json, GColor *color);
 
 size_t json_get_size(Json *json);
 
-JsonMark *json_mark(Json *json);
-void json_reset(Json *json, JsonMark *mark);
+JsonMark json_mark(Json *json);
+void json_reset(Json *json, JsonMark mark);
 void json_advance(Json *json);
 void json_skip_tree(Json *json);
+char *json_copy_tree(Json *json);
+
+void json_index(Json *json);
+bool json_seek(Json *json, const char *key);
+
+bool json_string_eq(JsonString s, const char *t);
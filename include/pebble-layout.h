@@ -3,6 +3,8 @@
 #include "pebble-json.h"
 
 typedef struct Layout Layout;
+typedef struct LayoutTemplate LayoutTemplate;
+typedef struct RepeatLayer RepeatLayer;
 
 typedef void* (*TypeCreateFunc)(GRect frame);
 typedef void (*TypeDestroyFunc)(void *object);
@@ -18,13 +20,59 @@ typedef struct {
     TypeCastToParentFunc cast;
 } TypeFuncs;
 
+typedef struct {
+    size_t json;
+    size_t tokens;
+    size_t strings;
+    size_t layer_data;
+    size_t dicts;
+    size_t fonts;
+    size_t images;
+    size_t text;
+    size_t total;
+    size_t parse_peak;
+} LayoutStats;
+
+typedef enum {
+    LayoutPhaseTokenize,
+    LayoutPhaseCapabilities,
+    LayoutPhaseTypeLookup,
+    LayoutPhaseFrame,
+    LayoutPhaseCreate,
+    LayoutPhaseParse,
+    LayoutPhaseChildren,
+    LayoutPhaseCount
+} LayoutPhase;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t ms;
+} LayoutPhaseStats;
+
+typedef void (*RepeatLayerBindCallback)(Layout *row, uint16_t index, void *context);
+
 Layout *layout_create(void);
+Layout *layout_create_with_arena(size_t size);
 void layout_parse_resource(Layout *layout, uint32_t resource_id);
+void layout_parse_binary_resource(Layout *layout, uint32_t resource_id);
+void layout_parse_resource_streaming(Layout *layout, uint32_t resource_id);
 void layout_parse(Layout *layout, const char *s);
+void layout_apply(Layout *layout, const char *patch);
 void layout_destroy(Layout *layout);
+LayoutTemplate *layout_template_create(Layout *layout, const char *s);
+LayoutTemplate *layout_template_create_with_resource(Layout *layout, uint32_t resource_id);
+void layout_template_destroy(LayoutTemplate *layout_template);
+Layout *layout_create_from_template(LayoutTemplate *layout_template, const char *overrides);
 void layout_add_type(Layout *layout, const char *type, TypeFuncs type_funcs, const char *parent_type);
 Layer *layout_get_layer(Layout *layout);
 void *layout_find_by_id(Layout *layout, const char *id);
+bool layout_materialize(Layout *layout, const char *id);
+void layout_dematerialize(Layout *layout, const char *id);
+void layout_set_value(Layout *layout, const char *key, const char *value);
+void layout_get_stats(Layout *layout, LayoutStats *stats);
+LayoutPhaseStats layout_profile_get(LayoutPhase phase);
+void layout_profile_reset(void);
+void layout_profile_log(void);
 void layout_add_font(Layout *layout, char *name, uint32_t resource_id);
 void layout_add_resource(Layout *layout, char *name, uint32_t resource_id);
 
@@ -33,3 +81,8 @@ void layout_add_text_type(Layout *layout);
 void layout_add_bitmap_type(Layout *layout);
 void layout_add_status_bar_type(Layout *layout);
 void layout_add_pdc_type(Layout *layout);
+void layout_add_repeat_type(Layout *layout);
+
+Layer *repeat_layer_get_layer(RepeatLayer *repeat_layer);
+void repeat_layer_set_data(RepeatLayer *repeat_layer, uint16_t count, RepeatLayerBindCallback bind, void *context);
+void repeat_layer_set_offset(RepeatLayer *repeat_layer, int16_t offset);
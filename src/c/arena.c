@@ -0,0 +1,76 @@
+#include <pebble.h>
+#include "arena.h"
+
+#define ALIGN(size) (((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+struct Chunk {
+    struct Chunk *next;
+    size_t size;
+    size_t used;
+};
+
+struct Arena {
+    struct Chunk *chunks;
+    size_t chunk_size;
+};
+
+static void *prv_chunk_data(struct Chunk *chunk) {
+    return (uint8_t *) chunk + ALIGN(sizeof(struct Chunk));
+}
+
+static struct Chunk *prv_chunk_create(void *mem, size_t size) {
+    struct Chunk *chunk = mem;
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+Arena *arena_create(size_t size) {
+    size = ALIGN(size);
+    // The arena and its first chunk share one allocation.
+    Arena *arena = malloc(ALIGN(sizeof(Arena)) + ALIGN(sizeof(struct Chunk)) + size);
+    arena->chunks = prv_chunk_create((uint8_t *) arena + ALIGN(sizeof(Arena)), size);
+    arena->chunk_size = size;
+    return arena;
+}
+
+void arena_destroy(Arena *arena) {
+    if (!arena) return;
+    struct Chunk *chunk = arena->chunks;
+    while (chunk->next) {
+        struct Chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    if (!arena) return malloc(size);
+
+    size = ALIGN(size);
+    struct Chunk *chunk = arena->chunks;
+    if (chunk->size - chunk->used < size) {
+        size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+        chunk = prv_chunk_create(malloc(ALIGN(sizeof(struct Chunk)) + chunk_size), chunk_size);
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    void *ptr = (uint8_t *) prv_chunk_data(chunk) + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+void arena_free(Arena *arena, void *ptr) {
+    // Arena memory is only released all at once by arena_destroy.
+    if (!arena) free(ptr);
+}
+
+char *arena_strndup(Arena *arena, const char *s, size_t len) {
+    char *copy = arena_alloc(arena, len + 1);
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
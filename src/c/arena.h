@@ -0,0 +1,12 @@
+#pragma once
+#include <pebble.h>
+
+typedef struct Arena Arena;
+
+// A NULL arena falls through to malloc/free, so callers don't need to care
+// whether their owner was created with one.
+Arena *arena_create(size_t size);
+void arena_destroy(Arena *arena);
+void *arena_alloc(Arena *arena, size_t size);
+void arena_free(Arena *arena, void *ptr);
+char *arena_strndup(Arena *arena, const char *s, size_t len);
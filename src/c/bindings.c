@@ -0,0 +1,243 @@
+#include <pebble.h>
+#include "bindings.h"
+#include "dict.h"
+
+struct Binding {
+    struct Binding *next;
+    TextLayer *layer;
+    char *template;
+    // The rendered text the layer shows, which the binding owns.
+    char *text;
+    size_t size;
+    void *scope;
+    bool dirty;
+};
+
+struct Ref {
+    struct Ref *next;
+    struct Binding *binding;
+};
+
+// One per key: its current value and the bindings that use it.
+struct Slot {
+    char *value;
+    struct Ref *refs;
+};
+
+struct Bindings {
+    Arena *arena;
+    struct Binding *bindings;
+    Dict *slots;
+    AppTimer *timer;
+};
+
+Bindings *bindings_create(Arena *arena) {
+    Bindings *bindings = arena_alloc(arena, sizeof(Bindings));
+    bindings->arena = arena;
+    bindings->bindings = NULL;
+    bindings->slots = dict_create(arena);
+    bindings->timer = NULL;
+    return bindings;
+}
+
+static struct Slot *prv_get_slot(Bindings *bindings, const char *key, size_t len) {
+    struct Slot *slot = dict_get_n(bindings->slots, key, len);
+    if (slot) return slot;
+
+    slot = arena_alloc(bindings->arena, sizeof(struct Slot));
+    slot->value = NULL;
+    slot->refs = NULL;
+    dict_put(bindings->slots, arena_strndup(bindings->arena, key, len), slot);
+    return slot;
+}
+
+// Calls back with each {{key}} in the template.
+typedef void (*KeyCallback)(Bindings *bindings, struct Binding *binding, const char *key, size_t len);
+
+static void prv_foreach_key(Bindings *bindings, struct Binding *binding, KeyCallback callback) {
+    for (const char *s = strstr(binding->template, "{{"); s; s = strstr(s, "{{")) {
+        const char *end = strstr(s + 2, "}}");
+        if (!end) return;
+        callback(bindings, binding, s + 2, end - s - 2);
+        s = end + 2;
+    }
+}
+
+static void prv_add_ref(Bindings *bindings, struct Binding *binding, const char *key, size_t len) {
+    struct Slot *slot = prv_get_slot(bindings, key, len);
+    struct Ref *ref = malloc(sizeof(struct Ref));
+    ref->binding = binding;
+    ref->next = slot->refs;
+    slot->refs = ref;
+}
+
+static void prv_remove_ref(Bindings *bindings, struct Binding *binding, const char *key, size_t len) {
+    struct Slot *slot = dict_get_n(bindings->slots, key, len);
+    if (!slot) return;
+    for (struct Ref **link = &slot->refs; *link; link = &(*link)->next) {
+        if ((*link)->binding != binding) continue;
+        struct Ref *ref = *link;
+        *link = ref->next;
+        free(ref);
+        return;
+    }
+}
+
+// Renders the template into buf, which holds size bytes, and returns the
+// length the full text needs.
+static size_t prv_render(Bindings *bindings, struct Binding *binding, char *buf, size_t size) {
+    size_t len = 0;
+    for (const char *s = binding->template; *s;) {
+        const char *value = NULL;
+        size_t value_len = 0;
+        const char *end = strncmp(s, "{{", 2) == 0 ? strstr(s + 2, "}}") : NULL;
+        if (end) {
+            struct Slot *slot = dict_get_n(bindings->slots, s + 2, end - s - 2);
+            value = slot && slot->value ? slot->value : "";
+            value_len = strlen(value);
+            s = end + 2;
+        } else {
+            value = s;
+            value_len = 1;
+            s++;
+        }
+        if (len + value_len < size) memcpy(buf + len, value, value_len);
+        len += value_len;
+    }
+    if (len < size) buf[len] = '\0';
+    return len;
+}
+
+// Rewrites the binding's text in place, only growing the buffer when the new
+// text doesn't fit.
+static void prv_update(Bindings *bindings, struct Binding *binding) {
+    size_t len = prv_render(bindings, binding, binding->text, binding->size);
+    if (len >= binding->size) {
+        binding->size = len + 1;
+        binding->text = realloc(binding->text, sizeof(char) * binding->size);
+        prv_render(bindings, binding, binding->text, binding->size);
+    }
+    binding->dirty = false;
+}
+
+// Bindings and their refs are made and dropped every time text is parsed or
+// a lazy layer is rebuilt, so unlike the slots they're on the heap.
+char *bindings_bind(Bindings *bindings, TextLayer *layer, char *template, void *scope) {
+    struct Binding *binding = malloc(sizeof(struct Binding));
+    binding->layer = layer;
+    binding->template = template;
+    binding->text = NULL;
+    binding->size = 0;
+    binding->scope = scope;
+    binding->next = bindings->bindings;
+    bindings->bindings = binding;
+    prv_foreach_key(bindings, binding, prv_add_ref);
+    prv_update(bindings, binding);
+    return binding->text;
+}
+
+static void prv_remove(Bindings *bindings, struct Binding **link) {
+    struct Binding *binding = *link;
+    *link = binding->next;
+    prv_foreach_key(bindings, binding, prv_remove_ref);
+    free(binding->template);
+    free(binding->text);
+    free(binding);
+}
+
+void bindings_unbind(Bindings *bindings, TextLayer *layer) {
+    for (struct Binding **link = &bindings->bindings; *link; link = &(*link)->next) {
+        if ((*link)->layer == layer) {
+            prv_remove(bindings, link);
+            return;
+        }
+    }
+}
+
+void bindings_unbind_scope(Bindings *bindings, void *scope) {
+    struct Binding **link = &bindings->bindings;
+    while (*link) {
+        if ((*link)->scope == scope) prv_remove(bindings, link);
+        else link = &(*link)->next;
+    }
+}
+
+static void prv_flush(void *context) {
+    Bindings *bindings = context;
+    bindings->timer = NULL;
+    for (struct Binding *binding = bindings->bindings; binding; binding = binding->next) {
+        if (!binding->dirty) continue;
+        prv_update(bindings, binding);
+        text_layer_set_text(binding->layer, binding->text);
+    }
+}
+
+void bindings_set_value(Bindings *bindings, const char *key, const char *value) {
+    struct Slot *slot = prv_get_slot(bindings, key, strlen(key));
+    if (slot->value && value && strcmp(slot->value, value) == 0) return;
+
+    free(slot->value);
+    slot->value = NULL;
+    if (value) {
+        size_t len = strlen(value);
+        slot->value = malloc(sizeof(char) * (len + 1));
+        memcpy(slot->value, value, len + 1);
+    }
+
+    for (struct Ref *ref = slot->refs; ref; ref = ref->next) ref->binding->dirty = true;
+    if (slot->refs && !bindings->timer) bindings->timer = app_timer_register(0, prv_flush, bindings);
+}
+
+static bool prv_slot_memory_callback(char *key, void *value, void *context) {
+    struct Slot *slot = value;
+    size_t *size = context;
+    *size += sizeof(struct Slot) + strlen(key) + 1;
+    if (slot->value) *size += strlen(slot->value) + 1;
+    for (struct Ref *ref = slot->refs; ref; ref = ref->next) *size += sizeof(struct Ref);
+    return true;
+}
+
+// Rendered text is counted by bindings_text_used() instead.
+size_t bindings_memory_used(Bindings *bindings) {
+    size_t size = sizeof(Bindings) + dict_memory_used(bindings->slots);
+    for (struct Binding *binding = bindings->bindings; binding; binding = binding->next) {
+        size += sizeof(struct Binding) + strlen(binding->template) + 1;
+    }
+    dict_foreach(bindings->slots, prv_slot_memory_callback, &size);
+    return size;
+}
+
+size_t bindings_text_used(Bindings *bindings) {
+    size_t size = 0;
+    for (struct Binding *binding = bindings->bindings; binding; binding = binding->next) {
+        size += binding->size;
+    }
+    return size;
+}
+
+static bool prv_slot_destroy_callback(char *key, void *value, void *context) {
+    Bindings *bindings = context;
+    struct Slot *slot = value;
+    free(slot->value);
+    while (slot->refs) {
+        struct Ref *next = slot->refs->next;
+        free(slot->refs);
+        slot->refs = next;
+    }
+    arena_free(bindings->arena, slot);
+    arena_free(bindings->arena, key);
+    return true;
+}
+
+void bindings_destroy(Bindings *bindings) {
+    if (bindings->timer) app_timer_cancel(bindings->timer);
+    bindings->timer = NULL;
+
+    while (bindings->bindings) prv_remove(bindings, &bindings->bindings);
+
+    dict_foreach(bindings->slots, prv_slot_destroy_callback, bindings);
+    dict_destroy(bindings->slots);
+    bindings->slots = NULL;
+
+    arena_free(bindings->arena, bindings);
+}
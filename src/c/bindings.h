@@ -0,0 +1,17 @@
+#pragma once
+#include <pebble.h>
+#include "arena.h"
+
+typedef struct Bindings Bindings;
+
+// TextLayers whose text contains {{key}} placeholders. Setting a value
+// re-renders the bound layers in place on the next turn of the event loop.
+// Each binding owns the text it renders, which lives until it's unbound.
+Bindings *bindings_create(Arena *arena);
+void bindings_destroy(Bindings *bindings);
+char *bindings_bind(Bindings *bindings, TextLayer *layer, char *template, void *scope);
+void bindings_unbind(Bindings *bindings, TextLayer *layer);
+void bindings_unbind_scope(Bindings *bindings, void *scope);
+void bindings_set_value(Bindings *bindings, const char *key, const char *value);
+size_t bindings_memory_used(Bindings *bindings);
+size_t bindings_text_used(Bindings *bindings);
@@ -1,98 +1,152 @@
-#include <@smallstoneapps/linked-list/linked-list.h>
+#include <pebble.h>
 #include "dict.h"
+#include "heap-peak.h"
 
-struct Dict {
-    LinkedRoot *entries;
-};
+#define MIN_CAPACITY 8
+
+// Marks a removed slot so probing continues past it.
+static char s_tombstone;
+#define TOMBSTONE (&s_tombstone)
 
 struct Entry {
+    uint32_t hash;
     char *key;
     void *value;
 };
 
-Dict *dict_create(void) {
-    Dict *dict = malloc(sizeof(Dict));
+// The table is on the heap even when the Dict is in an arena: it is replaced
+// as it grows, and an arena would keep every outgrown table.
+struct Dict {
+    Arena *arena;
+    struct Entry *entries;
+    uint16_t capacity;
+    uint16_t count;
+    uint16_t used;
+};
+
+static uint32_t prv_hash(const char *key, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t) key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+Dict *dict_create(Arena *arena) {
+    Dict *dict = arena_alloc(arena, sizeof(Dict));
+    dict->arena = arena;
     dict->entries = NULL;
+    dict->capacity = 0;
+    dict->count = 0;
+    dict->used = 0;
     return dict;
 }
 
-static bool prv_destroy_callback(void *object, void *context) {
-    free(object);
-    object = NULL;
-    return true;
+void dict_destroy(Dict *dict) {
+    free(dict->entries);
+    dict->entries = NULL;
+    arena_free(dict->arena, dict);
 }
 
-void dict_destroy(Dict *dict) {
-    if (dict->entries) {
-        linked_list_foreach(dict->entries, prv_destroy_callback, NULL);
-        linked_list_clear(dict->entries);
-        free(dict->entries);
-        dict->entries = NULL;
+static struct Entry *prv_find(Dict *dict, const char *key, size_t len, uint32_t hash) {
+    if (!dict->entries) return NULL;
+    uint16_t mask = dict->capacity - 1;
+    for (uint16_t i = hash & mask;; i = (i + 1) & mask) {
+        struct Entry *entry = &dict->entries[i];
+        if (entry->key == NULL) return NULL;
+        if (entry->key != TOMBSTONE && entry->hash == hash &&
+                strncmp(entry->key, key, len) == 0 && entry->key[len] == '\0') return entry;
     }
-    free(dict);
+}
+
+static struct Entry *prv_free_slot(struct Entry *entries, uint16_t capacity, uint32_t hash) {
+    uint16_t mask = capacity - 1;
+    uint16_t i = hash & mask;
+    while (entries[i].key != NULL && entries[i].key != TOMBSTONE) i = (i + 1) & mask;
+    return &entries[i];
+}
+
+static void prv_resize(Dict *dict, uint16_t capacity) {
+    struct Entry *entries = malloc(sizeof(struct Entry) * capacity);
+    memset(entries, 0, sizeof(struct Entry) * capacity);
+    heap_peak_sample();
+    for (uint16_t i = 0; i < dict->capacity; i++) {
+        struct Entry *entry = &dict->entries[i];
+        if (entry->key != NULL && entry->key != TOMBSTONE) *prv_free_slot(entries, capacity, entry->hash) = *entry;
+    }
+    free(dict->entries);
+    dict->entries = entries;
+    dict->capacity = capacity;
+    dict->used = dict->count;
 }
 
 void dict_put(Dict *dict, char *key, void *value) {
-    if (!dict->entries) dict->entries = linked_list_create_root();
-    struct Entry *entry = malloc(sizeof(struct Entry));
+    size_t len = strlen(key);
+    uint32_t hash = prv_hash(key, len);
+    struct Entry *entry = prv_find(dict, key, len, hash);
+    if (entry) {
+        entry->value = value;
+        return;
+    }
+
+    // Keep the load factor (tombstones included) under 3/4 so probes stay short.
+    if ((dict->used + 1) * 4 > dict->capacity * 3) {
+        uint16_t capacity = dict->capacity ? dict->capacity : MIN_CAPACITY;
+        while ((dict->count + 1) * 2 > capacity) capacity *= 2;
+        prv_resize(dict, capacity);
+    }
+
+    entry = prv_free_slot(dict->entries, dict->capacity, hash);
+    if (entry->key == NULL) dict->used += 1;
+    entry->hash = hash;
     entry->key = key;
     entry->value = value;
-    linked_list_append(dict->entries, entry);
-}
-
-static bool prv_find_by_key_callback(void *object1, void *object2) {
-    const char *key = (const char *) object1;
-    struct Entry *entry = (struct Entry *) object2;
-    return strcmp(key, entry->key) == 0;
+    dict->count += 1;
 }
 
 bool dict_contains(Dict *dict, const char *key) {
-    if (!dict->entries) return false;
-    return linked_list_contains_compare(dict->entries, (void *) key, prv_find_by_key_callback);
+    size_t len = strlen(key);
+    return prv_find(dict, key, len, prv_hash(key, len)) != NULL;
 }
 
 void *dict_get(Dict *dict, const char *key) {
-    if (!dict->entries) return NULL;
-    int16_t index = linked_list_find_compare(dict->entries, (void *) key, prv_find_by_key_callback);
-    if (index < 0) return NULL;
-    struct Entry *entry = (struct Entry *) linked_list_get(dict->entries, index);
-    return entry->value;
+    return dict_get_n(dict, key, strlen(key));
+}
+
+void *dict_get_n(Dict *dict, const char *key, size_t len) {
+    struct Entry *entry = prv_find(dict, key, len, prv_hash(key, len));
+    return entry ? entry->value : NULL;
 }
 
 void *dict_remove(Dict *dict, const char *key) {
-    if (!dict->entries) return NULL;
-    int16_t index = linked_list_find_compare(dict->entries, (void *) key, prv_find_by_key_callback);
-    if (index < 0) return NULL;
+    size_t len = strlen(key);
+    struct Entry *entry = prv_find(dict, key, len, prv_hash(key, len));
+    if (!entry) return NULL;
 
-    struct Entry *entry = (struct Entry *) linked_list_get(dict->entries, index);
     void *value = entry->value;
-    linked_list_remove(dict->entries, index);
-    free(entry);
+    entry->key = TOMBSTONE;
+    entry->value = NULL;
+    dict->count -= 1;
 
-    if (linked_list_count(dict->entries) == 0) {
+    if (dict->count == 0) {
         free(dict->entries);
         dict->entries = NULL;
+        dict->capacity = 0;
+        dict->used = 0;
     }
 
     return value;
 }
 
-struct ForEachData {
-    DictForEachCallback callback;
-    void *context;
-};
-
-static bool prv_foreach_callback(void *object, void *context) {
-    struct Entry *entry = (struct Entry *) object;
-    struct ForEachData *data = (struct ForEachData *) context;
-    return data->callback(entry->key, entry->value, data->context);
+size_t dict_memory_used(Dict *dict) {
+    return sizeof(Dict) + sizeof(struct Entry) * dict->capacity;
 }
 
 void dict_foreach(Dict *dict, DictForEachCallback callback, void *context) {
-    if (!dict->entries) return;
-    struct ForEachData data = {
-        .callback = callback,
-        .context = context
-    };
-    linked_list_foreach(dict->entries, prv_foreach_callback, &data);
+    for (uint16_t i = 0; i < dict->capacity; i++) {
+        struct Entry *entry = &dict->entries[i];
+        if (entry->key == NULL || entry->key == TOMBSTONE) continue;
+        if (!callback(entry->key, entry->value, context)) return;
+    }
 }
@@ -1,13 +1,16 @@
 #pragma once
+#include "arena.h"
 
 typedef struct Dict Dict;
 
 typedef bool (*DictForEachCallback)(char *key, void *value, void *context);
 
-Dict *dict_create(void);
+Dict *dict_create(Arena *arena);
 void dict_destroy(Dict *dict);
 void dict_put(Dict *dict, char *key, void *value);
 bool dict_contains(Dict *dict, const char *key);
 void *dict_get(Dict *dict, const char *key);
+void *dict_get_n(Dict *dict, const char *key, size_t len);
 void *dict_remove(Dict *dict, const char *key);
 void dict_foreach(Dict *dict, DictForEachCallback callback, void *context);
+size_t dict_memory_used(Dict *dict);
@@ -0,0 +1,48 @@
+#include <pebble.h>
+#include "font-cache.h"
+
+struct Entry {
+    struct Entry *next;
+    uint32_t resource_id;
+    uint16_t refs;
+    GFont font;
+};
+
+static struct Entry *s_entries;
+
+GFont font_cache_get(uint32_t resource_id) {
+    for (struct Entry *entry = s_entries; entry; entry = entry->next) {
+        if (entry->resource_id == resource_id) {
+            entry->refs += 1;
+            return entry->font;
+        }
+    }
+
+    GFont font = fonts_load_custom_font(resource_get_handle(resource_id));
+    if (!font) return NULL;
+
+    struct Entry *entry = malloc(sizeof(struct Entry));
+    entry->resource_id = resource_id;
+    entry->refs = 1;
+    entry->font = font;
+    entry->next = s_entries;
+    s_entries = entry;
+    return font;
+}
+
+void font_cache_release(GFont font) {
+    if (!font) return;
+
+    for (struct Entry **link = &s_entries; *link; link = &(*link)->next) {
+        struct Entry *entry = *link;
+        if (entry->font != font) continue;
+
+        entry->refs -= 1;
+        if (entry->refs == 0) {
+            *link = entry->next;
+            fonts_unload_custom_font(entry->font);
+            free(entry);
+        }
+        return;
+    }
+}
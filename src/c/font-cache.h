@@ -0,0 +1,7 @@
+#pragma once
+#include <pebble.h>
+
+// Custom fonts shared by every layout in the app. Each get takes a reference;
+// release drops it and unloads the font with the last one.
+GFont font_cache_get(uint32_t resource_id);
+void font_cache_release(GFont font);
@@ -0,0 +1,26 @@
+#include <pebble.h>
+#include "heap-peak.h"
+
+static uint16_t s_depth;
+static size_t s_high;
+
+HeapPeak heap_peak_start(void) {
+    HeapPeak mark = { .base = heap_bytes_used(), .outer = s_high };
+    s_high = mark.base;
+    s_depth += 1;
+    return mark;
+}
+
+void heap_peak_sample(void) {
+    if (s_depth == 0) return;
+    size_t used = heap_bytes_used();
+    if (used > s_high) s_high = used;
+}
+
+size_t heap_peak_end(HeapPeak mark) {
+    heap_peak_sample();
+    size_t peak = s_high > mark.base ? s_high - mark.base : 0;
+    if (mark.outer > s_high) s_high = mark.outer;
+    s_depth -= 1;
+    return peak;
+}
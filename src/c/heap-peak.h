@@ -0,0 +1,15 @@
+#pragma once
+#include <pebble.h>
+
+// The high-water mark of the heap while a layout parses. Anything that grows
+// a buffer during a parse samples the heap right after, so the mark catches
+// what was held at the worst moment rather than what was left at the end.
+// Parses can nest; an inner one also counts toward the outer one.
+typedef struct {
+    size_t base;
+    size_t outer;
+} HeapPeak;
+
+HeapPeak heap_peak_start(void);
+void heap_peak_sample(void);
+size_t heap_peak_end(HeapPeak mark);
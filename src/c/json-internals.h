@@ -0,0 +1,14 @@
+#pragma once
+#include <pebble-json.h>
+#include "jsmn/jsmn.h"
+
+// Tokenizes the len characters of s into a heap array sized from a scan of
+// its delimiters, in one jsmn pass. Returns jsmn's result; the array is the
+// caller's to free either way. json_create() builds its tokens with this.
+int json_tokenize(const char *s, size_t len, jsmntok_t **tokens, size_t *tokens_size);
+
+// Compiled layouts carry some values of the standard types already read.
+// Each of these reads the next token if it holds one, and otherwise returns
+// false without advancing, to be read from its text instead.
+bool json_next_compiled_type(Json *json, uint8_t *type);
+bool json_next_compiled_rect(Json *json, GRect *rect);
@@ -0,0 +1,153 @@
+// Generated by tools/gen_keywords.py. Do not edit.
+#include <pebble.h>
+#include "keywords.h"
+
+#define KEYWORD_TABLE_SIZE 64
+#define KEYWORD_NUM_BUCKETS 16
+
+static const char s_pool[] =
+    "GCompOpAssignInverted"
+    "HEALTH"
+    "or"
+    "SMARTSTRAP"
+    "COLOR"
+    "and"
+    "GCompOpSet"
+    "BW"
+    "none"
+    "dotted"
+    "bottom"
+    "StatusBarLayerSeparatorModeNone"
+    "RECT"
+    "assign"
+    "left"
+    "GTextAlignmentCenter"
+    "clear"
+    "bottom-right"
+    "top"
+    "StatusBarLayerSeparatorModeDotted"
+    "GAlignLeft"
+    "center"
+    "PLATFORM_BASALT"
+    "GAlignTop"
+    "bottom-left"
+    "GTextAlignmentLeft"
+    "MICROPHONE"
+    "GAlignBottomLeft"
+    "top-left"
+    "GAlignTopLeft"
+    "GAlignTopRight"
+    "top-right"
+    "PLATFORM_DIORITE"
+    "GCompOpOr"
+    "GCompOpAnd"
+    "ROUND"
+    "set"
+    "PLATFORM_APLITE"
+    "PLATFORM_CHALK"
+    "GTextAlignmentRight"
+    "GAlignBottom"
+    "right"
+    "GAlignBottomRight"
+    "GAlignCenter"
+    "GCompOpClear"
+    "GCompOpAssign"
+    "GAlignRight"
+    "inverted";
+
+static const uint8_t s_displace[KEYWORD_NUM_BUCKETS] = {
+    9, 1, 2, 0, 2, 2, 0, 44, 19, 9, 7, 0, 10, 2, 34, 8
+};
+
+static const struct {
+    uint16_t offset;
+    uint8_t len;
+    uint8_t keyword;
+} s_keywords[KEYWORD_TABLE_SIZE] = {
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 0, 21, KEYWORD_INVERTED },
+    { 21, 6, KEYWORD_HEALTH },
+    { 27, 2, KEYWORD_OR },
+    { 29, 10, KEYWORD_SMARTSTRAP },
+    { 39, 5, KEYWORD_COLOR },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 44, 3, KEYWORD_AND },
+    { 47, 10, KEYWORD_SET },
+    { 57, 2, KEYWORD_BW },
+    { 59, 4, KEYWORD_NONE },
+    { 63, 6, KEYWORD_DOTTED },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 69, 6, KEYWORD_BOTTOM },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 75, 31, KEYWORD_NONE },
+    { 106, 4, KEYWORD_RECT },
+    { 110, 6, KEYWORD_ASSIGN },
+    { 116, 4, KEYWORD_LEFT },
+    { 120, 20, KEYWORD_CENTER },
+    { 140, 5, KEYWORD_CLEAR },
+    { 145, 12, KEYWORD_BOTTOM_RIGHT },
+    { 157, 3, KEYWORD_TOP },
+    { 160, 33, KEYWORD_DOTTED },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 193, 10, KEYWORD_LEFT },
+    { 203, 6, KEYWORD_CENTER },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 209, 15, KEYWORD_PLATFORM_BASALT },
+    { 224, 9, KEYWORD_TOP },
+    { 233, 11, KEYWORD_BOTTOM_LEFT },
+    { 244, 18, KEYWORD_LEFT },
+    { 262, 10, KEYWORD_MICROPHONE },
+    { 272, 16, KEYWORD_BOTTOM_LEFT },
+    { 288, 8, KEYWORD_TOP_LEFT },
+    { 296, 13, KEYWORD_TOP_LEFT },
+    { 309, 14, KEYWORD_TOP_RIGHT },
+    { 323, 9, KEYWORD_TOP_RIGHT },
+    { 332, 16, KEYWORD_PLATFORM_DIORITE },
+    { 348, 9, KEYWORD_OR },
+    { 357, 10, KEYWORD_AND },
+    { 367, 5, KEYWORD_ROUND },
+    { 372, 3, KEYWORD_SET },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 375, 15, KEYWORD_PLATFORM_APLITE },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 390, 14, KEYWORD_PLATFORM_CHALK },
+    { 404, 19, KEYWORD_RIGHT },
+    { 423, 12, KEYWORD_BOTTOM },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 435, 5, KEYWORD_RIGHT },
+    { 440, 17, KEYWORD_BOTTOM_RIGHT },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 457, 12, KEYWORD_CENTER },
+    { 469, 12, KEYWORD_CLEAR },
+    { 481, 13, KEYWORD_ASSIGN },
+    { 494, 11, KEYWORD_RIGHT },
+    { 0, 0, KEYWORD_UNKNOWN },
+    { 505, 8, KEYWORD_INVERTED },
+};
+
+Keyword keyword_lookup(JsonString s) {
+    if (s.str == NULL) return KEYWORD_UNKNOWN;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < s.len; i++) {
+        hash ^= (uint8_t) s.str[i];
+        hash *= 16777619u;
+    }
+
+    uint32_t h = hash ^ s_displace[hash & (KEYWORD_NUM_BUCKETS - 1)];
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+
+    uint16_t i = h & (KEYWORD_TABLE_SIZE - 1);
+    if (s_keywords[i].len != s.len || strncmp(s_pool + s_keywords[i].offset, s.str, s.len) != 0) {
+        return KEYWORD_UNKNOWN;
+    }
+    return s_keywords[i].keyword;
+}
@@ -0,0 +1,37 @@
+// Generated by tools/gen_keywords.py. Do not edit.
+#pragma once
+#include <pebble-json.h>
+
+typedef enum {
+    KEYWORD_UNKNOWN = 0,
+    KEYWORD_LEFT,
+    KEYWORD_CENTER,
+    KEYWORD_RIGHT,
+    KEYWORD_TOP_LEFT,
+    KEYWORD_TOP,
+    KEYWORD_TOP_RIGHT,
+    KEYWORD_BOTTOM_LEFT,
+    KEYWORD_BOTTOM,
+    KEYWORD_BOTTOM_RIGHT,
+    KEYWORD_ASSIGN,
+    KEYWORD_INVERTED,
+    KEYWORD_OR,
+    KEYWORD_AND,
+    KEYWORD_CLEAR,
+    KEYWORD_SET,
+    KEYWORD_NONE,
+    KEYWORD_DOTTED,
+    KEYWORD_PLATFORM_APLITE,
+    KEYWORD_PLATFORM_BASALT,
+    KEYWORD_PLATFORM_CHALK,
+    KEYWORD_PLATFORM_DIORITE,
+    KEYWORD_BW,
+    KEYWORD_COLOR,
+    KEYWORD_HEALTH,
+    KEYWORD_RECT,
+    KEYWORD_ROUND,
+    KEYWORD_MICROPHONE,
+    KEYWORD_SMARTSTRAP,
+} Keyword;
+
+Keyword keyword_lookup(JsonString s);
@@ -1,5 +1,27 @@
 #pragma once
 #include <pebble-layout.h>
 
-GFont layout_get_font(Layout *layout, const char *name);
-uint32_t *layout_get_resource(Layout *layout, const char *name);
\ No newline at end of file
+GRect layout_next_rect(Json *json);
+GFont layout_get_font(Layout *layout, JsonString name);
+uint32_t *layout_get_resource(Layout *layout, JsonString name);
+GBitmap *layout_get_bitmap(Layout *layout, uint32_t *resource_id);
+GBitmap *layout_get_sub_bitmap(Layout *layout, uint32_t *resource_id, GRect source);
+GDrawCommandImage *layout_get_pdc(Layout *layout, uint32_t *resource_id);
+void layout_release_resource(Layout *layout, void *object);
+char *layout_bind_text(Layout *layout, TextLayer *layer, char *template);
+void layout_unbind_text(Layout *layout, TextLayer *layer);
+void layout_own_text(Layout *layout, char *text);
+// True while layout_apply() re-parses a layer, so types can tell a patch,
+// which only changes what it mentions, from a layer's first parse.
+bool layout_is_patching(Layout *layout);
+void layout_add_container_type(Layout *layout, const char *type, TypeFuncs type_funcs);
+
+// Standard types read their properties once per template node, so layouts
+// created from the template set them without going back to the JSON. compile
+// returns one heap block, freed with free().
+typedef void *(*TypeCompileFunc)(Layout *layout, Json *json);
+typedef void (*TypeInstanceFunc)(Layout *layout, const void *properties, void *object);
+void layout_add_compiled_type(Layout *layout, const char *type, TypeFuncs type_funcs,
+                              TypeCompileFunc compile, TypeInstanceFunc instance);
+LayoutTemplate *layout_template_create_from_tree(Layout *layout, Json *json);
+GRect layout_template_get_frame(LayoutTemplate *layout_template);
\ No newline at end of file
@@ -1,23 +1,82 @@
-#include <ctype.h>
 #include <limits.h>
 #include <pebble.h>
-#include <@smallstoneapps/linked-list/linked-list.h>
-#include "jsmn/jsmn.h"
 #include "pebble-json.h"
+#include "heap-peak.h"
+#include "json-internals.h"
+#include "profile.h"
 
 #define JSMN_PARENT_LINKS
 
+// Layout of resources written by tools/compile_layout.py
+#define BINARY_MAGIC "PLB2"
+#define BINARY_HEADER_SIZE 8
+#define BINARY_KIND_MASK 0x0F
+// Strings holding a color, with its GColor in value.
+#define BINARY_FLAG_COLOR 0x10
+// The value of a "type" naming a standard type, with its index in value.
+#define BINARY_FLAG_TYPE 0x20
+// A frame, with its x, y, w and h as int16 at start in the pool.
+#define BINARY_FLAG_FRAME 0x40
+#define BINARY_FRAME_SIZE 8
+
+#define STREAM_WINDOW_SIZE 128
+
+struct KeyFrame {
+    int16_t object;
+    int16_t start;
+    int16_t count;
+};
+
+// The tokens of one streamed layer, starting at base, tokenized from the
+// placeholder token its parent has in its place.
+struct Segment {
+    int16_t placeholder;
+    int16_t base;
+};
+
+// A token of a compiled layout, kept in memory as it is in the resource.
+// The type is a jsmntype_t with BINARY_FLAG_* bits above it.
+struct BinaryToken {
+    uint8_t type;
+    uint8_t value;
+    uint16_t size;
+    uint16_t start;
+    uint16_t len;
+};
+
 struct Json {
     char *buf;
+    size_t buf_size;
     bool free_buf;
-    LinkedRoot *marks;
+    // Compiled resources keep their packed tokens and an interned pool
+    // instead of jsmn tokens and the source text.
+    struct BinaryToken *packed;
     jsmntok_t *tokens;
+    size_t tokens_size;
+    // Index of the last token in each token's subtree.
+    int16_t *ends;
+    size_t ends_size;
     int16_t num_tokens;
     int16_t index;
-};
-
-struct JsonMark {
-    int16_t index;
+    // Key indexes of the objects being read, innermost last. Their keys
+    // share one buffer.
+    struct KeyFrame *frames;
+    int16_t num_frames;
+    int16_t frames_size;
+    int16_t *keys;
+    int16_t keys_size;
+    // Streamed resources keep no copy of the text; token text is read on
+    // demand into a window that's refilled when a token falls outside it.
+    // Only the layers being read are tokenized, each in its own segment
+    // after its parent's.
+    ResHandle handle;
+    struct Segment *segments;
+    int16_t num_segments;
+    int16_t segments_size;
+    char *window;
+    uint32_t window_start;
+    uint16_t window_len;
+    uint16_t window_size;
 };
 
 Json *json_create_with_resource(uint32_t resource_id) {
@@ -31,30 +90,422 @@ Json *json_create_with_resource(uint32_t resource_id) {
     return json_create(json, true);
 }
 
-Json *json_create(const char *s, bool free_on_destroy) {
+static Json *prv_json_create(char *buf, bool free_on_destroy) {
     Json *json = malloc(sizeof(Json));
-    json->buf = (char *) s;
+    json->buf = buf;
+    json->buf_size = 0;
     json->free_buf = free_on_destroy;
+    json->packed = NULL;
+    json->tokens = NULL;
+    json->tokens_size = 0;
+    json->ends = NULL;
+    json->ends_size = 0;
+    json->num_tokens = 0;
+    json->index = 0;
+    json->frames = NULL;
+    json->num_frames = 0;
+    json->frames_size = 0;
+    json->keys = NULL;
+    json->keys_size = 0;
+    json->handle = NULL;
+    json->segments = NULL;
+    json->num_segments = 0;
+    json->segments_size = 0;
+    json->window = NULL;
+    json->window_start = 0;
+    json->window_len = 0;
+    json->window_size = 0;
+    return json;
+}
 
-    jsmn_parser parser;
-    jsmn_init(&parser);
+static jsmntok_t prv_token(Json *json, int16_t i) {
+    if (!json->packed) return json->tokens[i];
 
-    size_t s_len = strlen(s);
-    int num_tokens = jsmn_parse(&parser, s, s_len, NULL, 0);
-    json->tokens = malloc(sizeof(jsmntok_t) * num_tokens);
+    struct BinaryToken *tok = &json->packed[i];
+    return (jsmntok_t) {
+        .type = tok->type & BINARY_KIND_MASK,
+        .start = tok->start,
+        .end = tok->start + tok->len,
+        .size = tok->size
+    };
+}
 
-    jsmn_init(&parser); // reset parser for actual pass
-    json->num_tokens = jsmn_parse(&parser, s, s_len, json->tokens, num_tokens);
-    json->index = 0;
+// Children follow their parent, so walking backwards every child's extent is
+// known by the time its parent is reached. Fails if a token claims more
+// children than follow it, which only a corrupt compiled layout can do.
+static bool prv_build_ends(Json *json, int16_t first) {
+    if (json->num_tokens <= 0) return true;
+    if (!json->ends) {
+        json->ends = malloc(sizeof(int16_t) * json->num_tokens);
+        json->ends_size = json->num_tokens;
+        heap_peak_sample();
+    }
+    for (int16_t i = json->num_tokens - 1; i >= first; i--) {
+        int16_t end = i;
+        for (int j = 0; j < prv_token(json, i).size; j++) {
+            if (end + 1 >= json->num_tokens) return false;
+            end = json->ends[end + 1];
+        }
+        json->ends[i] = end;
+    }
+    return true;
+}
+
+static bool prv_valid_binary_token(const struct BinaryToken *tok, uint16_t pool_size) {
+    if ((uint32_t) tok->start + tok->len > pool_size) return false;
+
+    uint8_t flags = tok->type & ~BINARY_KIND_MASK;
+    switch (tok->type & BINARY_KIND_MASK) {
+        case JSMN_OBJECT:
+        case JSMN_ARRAY:
+            return flags == 0 || (flags == BINARY_FLAG_FRAME && tok->len == BINARY_FRAME_SIZE);
+        case JSMN_STRING:
+            return tok->size <= 1 && (flags == 0 || flags == BINARY_FLAG_COLOR || flags == BINARY_FLAG_TYPE);
+        case JSMN_PRIMITIVE:
+            return tok->size == 0 && flags == 0;
+        default:
+            return false;
+    }
+}
 
+// Everything read from the resource is checked against its size, so a
+// truncated or corrupt file fails to load instead of reading out of bounds.
+Json *json_create_with_binary_resource(uint32_t resource_id) {
+    ResHandle handle = resource_get_handle(resource_id);
+
+    uint8_t header[BINARY_HEADER_SIZE];
+    if (!handle || resource_load_byte_range(handle, 0, header, BINARY_HEADER_SIZE) != BINARY_HEADER_SIZE ||
+            memcmp(header, BINARY_MAGIC, 4) != 0) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "resource %d is not a compiled layout", (int) resource_id);
+        return NULL;
+    }
+    uint16_t num_tokens = header[4] | header[5] << 8;
+    uint16_t pool_size = header[6] | header[7] << 8;
+    uint32_t pool_offset = BINARY_HEADER_SIZE + (uint32_t) num_tokens * sizeof(struct BinaryToken);
+    if (num_tokens == 0 || num_tokens > INT16_MAX || resource_size(handle) < pool_offset + pool_size) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "compiled layout %d is truncated", (int) resource_id);
+        return NULL;
+    }
+
+    PROFILE_START(LayoutPhaseTokenize);
+    char *pool = malloc(sizeof(char) * (pool_size + 1));
+    size_t loaded = resource_load_byte_range(handle, pool_offset, (uint8_t *) pool, pool_size);
+    pool[pool_size] = '\0';
+
+    // The tokens are little-endian, like the watch, so they load as they are.
+    Json *json = prv_json_create(pool, true);
+    json->buf_size = pool_size + 1;
+    json->packed = malloc(sizeof(struct BinaryToken) * num_tokens);
+    json->tokens_size = num_tokens;
+    json->num_tokens = num_tokens;
+    heap_peak_sample();
+    size_t len = sizeof(struct BinaryToken) * num_tokens;
+    bool valid = loaded == pool_size &&
+                 resource_load_byte_range(handle, BINARY_HEADER_SIZE, (uint8_t *) json->packed, len) == len;
+    for (int16_t i = 0; valid && i < json->num_tokens; i++) {
+        valid = prv_valid_binary_token(&json->packed[i], pool_size);
+    }
+    valid = valid && prv_build_ends(json, 0);
+    PROFILE_END(LayoutPhaseTokenize);
+
+    if (!valid) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "compiled layout %d is corrupt", (int) resource_id);
+        json_destroy(json);
+        return NULL;
+    }
     return json;
 }
 
-static bool prv_marks_destroy(void *object, void *context) {
-    free(object);
+struct TokenCount {
+    size_t count;
+    bool in_string;
+    bool escaped;
+};
+
+// Every token but the first follows a '{', '[', ':' or ',' outside of a
+// string, so counting those bounds the token count without a jsmn pass.
+static void prv_count_tokens(struct TokenCount *count, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        if (count->escaped) {
+            count->escaped = false;
+        } else if (count->in_string) {
+            if (c == '\\') count->escaped = true;
+            else if (c == '"') count->in_string = false;
+        } else if (c == '"') {
+            count->in_string = true;
+        } else if (c == '{' || c == '[' || c == ':' || c == ',') {
+            count->count++;
+        }
+    }
+}
+
+static const char *prv_token_text(Json *json, const jsmntok_t *tok) {
+    if (json->buf) return json->buf + tok->start;
+
+    uint32_t start = tok->start, end = tok->end;
+    if (start < json->window_start || end > json->window_start + json->window_len) {
+        json->window_start = start;
+        json->window_len = resource_load_byte_range(json->handle, start, (uint8_t *) json->window, json->window_size);
+    }
+    return json->window + (start - json->window_start);
+}
+
+static int prv_stream_char(Json *json, uint32_t pos) {
+    if (pos < json->window_start || pos >= json->window_start + json->window_len) {
+        json->window_start = pos;
+        json->window_len = resource_load_byte_range(json->handle, pos, (uint8_t *) json->window, json->window_size);
+        if (json->window_len == 0) return -1;
+    }
+    return (uint8_t) json->window[pos - json->window_start];
+}
+
+// Token text is read through the window, so it has to fit the longest token.
+static bool prv_stream_fit(Json *json, uint32_t len) {
+    if (len <= json->window_size) return true;
+    if (len > UINT16_MAX) return false;
+    json->window_size = len;
+    json->window = realloc(json->window, sizeof(char) * json->window_size);
+    json->window_len = 0;
+    heap_peak_sample();
     return true;
 }
 
+static int16_t prv_stream_alloc(Json *json) {
+    if ((size_t) json->num_tokens == json->tokens_size) {
+        if (json->tokens_size >= INT16_MAX / 2) return -1;
+        json->tokens_size = json->tokens_size ? json->tokens_size * 2 : 16;
+        json->tokens = realloc(json->tokens, sizeof(jsmntok_t) * json->tokens_size);
+        json->ends = realloc(json->ends, sizeof(int16_t) * json->tokens_size);
+        json->ends_size = json->tokens_size;
+        heap_peak_sample();
+    }
+    return json->num_tokens++;
+}
+
+// The innermost object or array still open at or before i, as jsmn finds it.
+static int16_t prv_stream_open(Json *json, int16_t base, int16_t i) {
+    for (; i >= base; i--) {
+        if (json->tokens[i].end == -1) return i;
+    }
+    return -1;
+}
+
+// Leaves pos on the closing quote.
+static int prv_stream_string(Json *json, uint32_t *pos, uint32_t end) {
+    for (uint32_t i = *pos + 1; i < end; i++) {
+        int c = prv_stream_char(json, i);
+        if (c <= 0) break;
+        if (c == '"') {
+            *pos = i;
+            return 0;
+        }
+        if (c != '\\' || i + 1 >= end) continue;
+        switch (prv_stream_char(json, ++i)) {
+            case '"': case '/': case '\\': case 'b': case 'f': case 'r': case 'n': case 't':
+                break;
+            case 'u':
+                for (int j = 0; j < 4 && i + 1 < end; j++) {
+                    c = prv_stream_char(json, ++i);
+                    if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))) {
+                        return JSMN_ERROR_INVAL;
+                    }
+                }
+                break;
+            default:
+                return JSMN_ERROR_INVAL;
+        }
+    }
+    return JSMN_ERROR_PART;
+}
+
+// Tokenizes the streamed text in [pos, end) after the tokens already there,
+// the way jsmn does. Objects in the "layers" array of the first token are
+// deferred: each is left as one empty object token spanning its text, for
+// json_index() to tokenize when the layer is read. Their text is still
+// checked, so an error anywhere in the range fails here. Returns the number
+// of tokens added or a jsmn error.
+static int prv_stream_tokenize(Json *json, uint32_t pos, uint32_t end) {
+    int16_t base = json->num_tokens;
+    int16_t super = -1;
+    int16_t layers_key = -1;
+    int16_t layers_array = -1;
+    // While a deferred object is open only the objects and arrays open in it
+    // are kept, on top of it, to match brackets.
+    int16_t deferred = -1;
+
+    for (; pos < end; pos++) {
+        int c = prv_stream_char(json, pos);
+        if (c <= 0) break;
+        switch (c) {
+            case '{': case '[': {
+                int16_t i = prv_stream_alloc(json);
+                if (i < 0) return JSMN_ERROR_NOMEM;
+                jsmntype_t type = c == '{' ? JSMN_OBJECT : JSMN_ARRAY;
+                json->tokens[i] = (jsmntok_t) { .type = type, .start = pos, .end = -1, .size = 0 };
+                if (deferred >= 0) break;
+                if (super >= 0) json->tokens[super].size++;
+                if (type == JSMN_ARRAY && super >= 0 && super == layers_key) layers_array = i;
+                if (type == JSMN_OBJECT && super >= 0 && super == layers_array) deferred = i;
+                else super = i;
+                break;
+            }
+            case '}': case ']': {
+                jsmntype_t type = c == '}' ? JSMN_OBJECT : JSMN_ARRAY;
+                int16_t i = deferred >= 0 ? json->num_tokens - 1 : prv_stream_open(json, base, json->num_tokens - 1);
+                if (i < 0 || json->tokens[i].type != type) return JSMN_ERROR_INVAL;
+                if (deferred >= 0 && i != deferred) {
+                    json->num_tokens--;
+                    break;
+                }
+                json->tokens[i].end = pos + 1;
+                if (i == deferred) deferred = -1;
+                else super = prv_stream_open(json, base, i - 1);
+                break;
+            }
+            case '"': {
+                uint32_t start = pos + 1;
+                int r = prv_stream_string(json, &pos, end);
+                if (r < 0) return r;
+                if (!prv_stream_fit(json, pos - start)) return JSMN_ERROR_NOMEM;
+                if (deferred >= 0) break;
+
+                int16_t i = prv_stream_alloc(json);
+                if (i < 0) return JSMN_ERROR_NOMEM;
+                json->tokens[i] = (jsmntok_t) { .type = JSMN_STRING, .start = start, .end = pos, .size = 0 };
+                if (super >= 0) json->tokens[super].size++;
+                if (super == base && json->tokens[base].type == JSMN_OBJECT && pos - start == 6 &&
+                        strncmp(prv_token_text(json, &json->tokens[i]), "layers", 6) == 0) {
+                    layers_key = i;
+                }
+                break;
+            }
+            case '\t': case '\r': case '\n': case ' ':
+                break;
+            case ':':
+                if (deferred < 0) super = json->num_tokens - 1;
+                break;
+            case ',':
+                if (deferred < 0 && super >= 0 && json->tokens[super].type != JSMN_ARRAY &&
+                        json->tokens[super].type != JSMN_OBJECT) {
+                    super = prv_stream_open(json, base, json->num_tokens - 1);
+                }
+                break;
+            default: {
+                uint32_t start = pos;
+                for (; pos < end; pos++) {
+                    c = prv_stream_char(json, pos);
+                    if (c <= 0 || strchr(":\t\r\n ,]}", c)) break;
+                    if (c < 32 || c >= 127) return JSMN_ERROR_INVAL;
+                }
+                if (!prv_stream_fit(json, pos - start)) return JSMN_ERROR_NOMEM;
+                pos--;
+                if (deferred >= 0) break;
+
+                int16_t i = prv_stream_alloc(json);
+                if (i < 0) return JSMN_ERROR_NOMEM;
+                json->tokens[i] = (jsmntok_t) { .type = JSMN_PRIMITIVE, .start = start, .end = pos + 1, .size = 0 };
+                if (super >= 0) json->tokens[super].size++;
+                break;
+            }
+        }
+    }
+
+    // The text ends inside a string, object or array.
+    if (deferred >= 0 || prv_stream_open(json, base, json->num_tokens - 1) >= 0) return JSMN_ERROR_INVAL;
+    return json->num_tokens - base;
+}
+
+// An empty streamed object may be a deferred layer. Its tokens are added as
+// a new segment, which json_reset() drops once the cursor goes back before
+// it, and the cursor moves to the layer's own object token.
+static void prv_stream_expand(Json *json) {
+    int16_t placeholder = json->index;
+    jsmntok_t *tok = &json->tokens[placeholder];
+    if (tok->type != JSMN_OBJECT || tok->size != 0) return;
+    struct Segment *top = json->num_segments > 0 ? &json->segments[json->num_segments - 1] : NULL;
+    if (top && top->base == placeholder) return;
+    if (top && top->placeholder == placeholder) {
+        json->index = top->base;
+        return;
+    }
+
+    if (json->num_segments == json->segments_size) {
+        json->segments_size = json->segments_size ? json->segments_size * 2 : 4;
+        json->segments = realloc(json->segments, sizeof(struct Segment) * json->segments_size);
+        heap_peak_sample();
+    }
+    int16_t base = json->num_tokens;
+    PROFILE_START(LayoutPhaseTokenize);
+    int r = prv_stream_tokenize(json, tok->start, tok->end);
+    PROFILE_END(LayoutPhaseTokenize);
+    if (r <= 0) {
+        // Only running out of memory gets here; the whole text was checked.
+        APP_LOG(APP_LOG_LEVEL_ERROR, "could not read streamed layer (%d)", r);
+        json->num_tokens = base;
+        return;
+    }
+    prv_build_ends(json, base);
+    json->segments[json->num_segments++] = (struct Segment) { .placeholder = placeholder, .base = base };
+    json->index = base;
+}
+
+// Tokenizes the layers as they're read rather than the whole file up front,
+// so the tokens held are those of the layers from the root to the one being
+// built. The text is read once to check it, and again for each level of
+// layers above any part of it.
+Json *json_create_with_resource_streaming(uint32_t resource_id) {
+    ResHandle handle = resource_get_handle(resource_id);
+
+    PROFILE_START(LayoutPhaseTokenize);
+    Json *json = prv_json_create(NULL, false);
+    json->handle = handle;
+    json->window_size = STREAM_WINDOW_SIZE;
+    json->window = malloc(sizeof(char) * json->window_size);
+    heap_peak_sample();
+
+    int r = prv_stream_tokenize(json, 0, resource_size(handle));
+    if (r < 0) json->num_tokens = r;
+    else prv_build_ends(json, 0);
+    PROFILE_END(LayoutPhaseTokenize);
+
+    return json;
+}
+
+int json_tokenize(const char *s, size_t len, jsmntok_t **tokens, size_t *tokens_size) {
+    struct TokenCount count = { .count = 1 };
+    prv_count_tokens(&count, s, len);
+    size_t num_tokens = count.count;
+    *tokens = malloc(sizeof(jsmntok_t) * num_tokens);
+    *tokens_size = num_tokens;
+    heap_peak_sample();
+
+    jsmn_parser parser;
+    jsmn_init(&parser);
+    int r;
+    while ((r = jsmn_parse(&parser, s, len, *tokens, num_tokens)) == JSMN_ERROR_NOMEM) {
+        // jsmn picks up where it ran out of tokens
+        num_tokens *= 2;
+        *tokens = realloc(*tokens, sizeof(jsmntok_t) * num_tokens);
+        *tokens_size = num_tokens;
+        heap_peak_sample();
+    }
+    return r;
+}
+
+Json *json_create(const char *s, bool free_on_destroy) {
+    PROFILE_START(LayoutPhaseTokenize);
+    Json *json = prv_json_create((char *) s, free_on_destroy);
+
+    size_t s_len = strlen(s);
+    json->buf_size = s_len + 1;
+    json->num_tokens = json_tokenize(s, s_len, &json->tokens, &json->tokens_size);
+    prv_build_ends(json, 0);
+    PROFILE_END(LayoutPhaseTokenize);
+
+    return json;
+}
+
 void json_destroy(Json *json) {
     json->index = -1;
     json->num_tokens = -1;
@@ -62,12 +513,23 @@ void json_destroy(Json *json) {
     free(json->tokens);
     json->tokens = NULL;
 
-    if (json->marks) {
-        linked_list_foreach(json->marks, prv_marks_destroy, NULL);
-        linked_list_clear(json->marks);
-        free(json->marks);
-        json->marks = NULL;
-    }
+    free(json->packed);
+    json->packed = NULL;
+
+    free(json->ends);
+    json->ends = NULL;
+
+    free(json->frames);
+    json->frames = NULL;
+
+    free(json->keys);
+    json->keys = NULL;
+
+    free(json->segments);
+    json->segments = NULL;
+
+    free(json->window);
+    json->window = NULL;
 
     if (json->free_buf) free(json->buf);
     json->buf = NULL;
@@ -75,146 +537,189 @@ void json_destroy(Json *json) {
     free(json);
 }
 
+void json_get_memory(Json *json, size_t *text, size_t *tokens) {
+    *text = (json->free_buf ? json->buf_size : 0) + json->window_size;
+    *tokens = (json->packed ? sizeof(struct BinaryToken) : sizeof(jsmntok_t)) * json->tokens_size +
+              sizeof(int16_t) * json->keys_size +
+              sizeof(struct KeyFrame) * json->frames_size;
+    *tokens += sizeof(int16_t) * json->ends_size + sizeof(struct Segment) * json->segments_size;
+}
+
 bool json_is_string(Json *json) {
-    return json->tokens[json->index].type == JSMN_STRING;
+    return prv_token(json, json->index).type == JSMN_STRING;
 }
 
 bool json_is_primitive(Json *json) {
-    return json->tokens[json->index].type == JSMN_PRIMITIVE;
+    return prv_token(json, json->index).type == JSMN_PRIMITIVE;
 }
 
 bool json_is_array(Json *json) {
-    return json->tokens[json->index].type == JSMN_ARRAY;
+    return prv_token(json, json->index).type == JSMN_ARRAY;
 }
 
 bool json_is_object(Json *json) {
-    return json->tokens[json->index].type == JSMN_OBJECT;
+    return prv_token(json, json->index).type == JSMN_OBJECT;
 }
 
 bool json_has_next(Json *json) {
-    return json->tokens != NULL && json->num_tokens > -1 && json->index < json->num_tokens;
+    return (json->tokens || json->packed) && json->num_tokens > -1 && json->index < json->num_tokens;
 }
 
-static jsmntok_t *prv_json_next(Json *json) {
-    return &json->tokens[++json->index];
+static jsmntok_t prv_json_next(Json *json) {
+    return prv_token(json, ++json->index);
 }
 
 char *json_next_string(Json *json) {
-    jsmntok_t *tok = prv_json_next(json);
-    if (tok->type != JSMN_STRING) return NULL;
-    size_t len = tok->end - tok->start;
+    jsmntok_t tok = prv_json_next(json);
+    if (tok.type != JSMN_STRING) return NULL;
+    size_t len = tok.end - tok.start;
     char *s = malloc(sizeof(char) * (len + 1));
     memset(s, 0, len + 1);
-    return strncpy(s, json->buf + tok->start, len);
+    if (!json->buf) {
+        resource_load_byte_range(json->handle, tok.start, (uint8_t *) s, len);
+        return s;
+    }
+    return strncpy(s, json->buf + tok.start, len);
+}
+
+JsonString json_next_string_view(Json *json) {
+    jsmntok_t tok = prv_json_next(json);
+    if (tok.type != JSMN_STRING) return (JsonString) { .str = NULL, .len = 0 };
+    return (JsonString) {
+        .str = prv_token_text(json, &tok),
+        .len = tok.end - tok.start
+    };
+}
+
+// Parses a signed number from a token span without copying it. Returns false
+// unless the whole span is a number, but *value always holds the leading part.
+static bool prv_parse_number(const char *s, size_t len, int base, int *value) {
+    size_t i = 0;
+    bool neg = false;
+    if (i < len && (s[i] == '-' || s[i] == '+')) neg = s[i++] == '-';
+    if (base == 16 && i + 1 < len && s[i] == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X')) i += 2;
+
+    size_t digits = i;
+    int64_t acc = 0;
+    bool overflow = false;
+    for (; i < len; i++) {
+        char c = s[i];
+        int d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else break;
+        if (d >= base) break;
+        acc = acc * base + d;
+        if (acc > INT_MAX) {
+            overflow = true;
+            acc = INT_MAX;
+        }
+    }
+
+    *value = neg ? -acc : acc;
+    return i == len && i > digits && !overflow;
+}
+
+bool json_try_next_bool(Json *json, bool *value) {
+    jsmntok_t tok = prv_json_next(json);
+    *value = false;
+    if (tok.type != JSMN_PRIMITIVE) return false;
+    JsonString s = { .str = prv_token_text(json, &tok), .len = tok.end - tok.start };
+    *value = json_string_eq(s, "true");
+    return *value || json_string_eq(s, "false");
 }
 
 bool json_next_bool(Json *json) {
-    jsmntok_t *tok = prv_json_next(json);
-    size_t len = tok->end - tok->start;
-    return tok->type == JSMN_PRIMITIVE && \
-        strlen("true") == len && \
-        strncmp(json->buf + tok->start, "true", len) == 0;
+    bool value;
+    json_try_next_bool(json, &value);
+    return value;
+}
+
+bool json_try_next_int(Json *json, int *value) {
+    jsmntok_t tok = prv_json_next(json);
+    *value = 0;
+    if (tok.type != JSMN_PRIMITIVE) return false;
+    return prv_parse_number(prv_token_text(json, &tok), tok.end - tok.start, 10, value);
 }
 
 int json_next_int(Json *json) {
-    jsmntok_t *tok = prv_json_next(json);
-    if (tok->type != JSMN_PRIMITIVE) return 0;
-    size_t len = (tok->end - tok->start);
-    char *s = malloc(sizeof(char) * (len + 1));
-    memset(s, 0, len + 1);
-    strncpy(s, json->buf + tok->start, len);
-    int i = atoi(s);
-    free(s);
-    return i;
-}
-
-static unsigned long
- prv_strtoul(const char *nptr, char **endptr, int base)
- {
-     const char *s;
-     unsigned long acc, cutoff;
-     int c;
-     int neg, any, cutlim;
-     s = nptr;
-     do {
-         c = (unsigned char) *s++;
-     } while (isspace(c));
-     if (c == '-') {
-         neg = 1;
-         c = *s++;
-     } else {
-         neg = 0;
-         if (c == '+')
-             c = *s++;
-     }
-     if ((base == 0 || base == 16) &&
-         c == '0' && (*s == 'x' || *s == 'X')) {
-         c = s[1];
-         s += 2;
-         base = 16;
-     }
-     if (base == 0)
-         base = c == '0' ? 8 : 10;
-     cutoff = ULONG_MAX / (unsigned long)base;
-     cutlim = ULONG_MAX % (unsigned long)base;
-     for (acc = 0, any = 0;; c = (unsigned char) *s++) {
-         if (isdigit(c))
-             c -= '0';
-         else if (isalpha(c))
-             c -= isupper(c) ? 'A' - 10 : 'a' - 10;
-         else
-             break;
-         if (c >= base)
-             break;
-         if (any < 0)
-             continue;
-         if (acc > cutoff || (acc == cutoff && c > cutlim)) {
-             any = -1;
-             acc = ULONG_MAX;
-         } else {
-             any = 1;
-             acc *= (unsigned long)base;
-             acc += c;
-         }
-     }
-     if (neg && any > 0)
-         acc = -acc;
-     if (endptr != 0)
-         *endptr = (char *) (any ? s - 1 : nptr);
-     return (acc);
- }
+    int value;
+    json_try_next_int(json, &value);
+    return value;
+}
+
+bool json_try_next_color(Json *json, GColor *color) {
+    jsmntok_t tok = prv_json_next(json);
+    if (json->packed && (json->packed[json->index].type & BINARY_FLAG_COLOR)) {
+        *color = (GColor) { .argb = json->packed[json->index].value };
+        return true;
+    }
+
+    int hex = 0;
+    bool ok = false;
+    if (tok.type == JSMN_STRING) {
+        const char *s = prv_token_text(json, &tok);
+        size_t len = tok.end - tok.start;
+        if (len > 0 && s[0] == '#') {
+            s++;
+            len--;
+        }
+        prv_parse_number(s, len, 16, &hex);
+        // Exactly RRGGBB, without the sign or 0x the number parser allows.
+        ok = len == 6;
+        for (size_t i = 0; ok && i < len; i++) {
+            char c = s[i];
+            ok = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        }
+    }
+    *color = GColorFromHEX(hex);
+    return ok;
+}
 
 GColor json_next_color(Json *json) {
-    char *s = json_next_string(json);
-    GColor color = GColorFromHEX(prv_strtoul(s + (s[0] == '#' ? 1 : 0), NULL, 16));
-    free(s);
+    GColor color;
+    json_try_next_color(json, &color);
     return color;
 }
 
-size_t json_get_size(Json *json) {
-    return json->tokens[json->index].size;
+bool json_next_compiled_type(Json *json, uint8_t *type) {
+    bool has_next = json->packed && json->index + 1 < json->num_tokens;
+    struct BinaryToken *tok = has_next ? &json->packed[json->index + 1] : NULL;
+    if (!tok || !(tok->type & BINARY_FLAG_TYPE)) return false;
+
+    json->index++;
+    *type = tok->value;
+    return true;
 }
 
-JsonMark *json_mark(Json *json) {
-    if (!json->marks) json->marks = linked_list_create_root();
-    JsonMark *mark = malloc(sizeof(JsonMark));
-    mark->index = json->index;
-    linked_list_prepend(json->marks, mark);
-    return mark;
+bool json_next_compiled_rect(Json *json, GRect *rect) {
+    bool has_next = json->packed && json->index + 1 < json->num_tokens;
+    struct BinaryToken *tok = has_next ? &json->packed[json->index + 1] : NULL;
+    if (!tok || !(tok->type & BINARY_FLAG_FRAME)) return false;
+
+    const uint8_t *p = (const uint8_t *) json->buf + tok->start;
+    *rect = GRect((int16_t) (p[0] | p[1] << 8), (int16_t) (p[2] | p[3] << 8),
+                  (int16_t) (p[4] | p[5] << 8), (int16_t) (p[6] | p[7] << 8));
+    json_skip_tree(json);
+    return true;
 }
 
-void json_reset(Json *json, JsonMark *mark) {
-    if (!json->marks) return;
-    int16_t index = linked_list_find(json->marks, mark);
-    if (index > -1) {
-        json->index = mark->index;
-        linked_list_remove(json->marks, index);
-        free(mark);
+size_t json_get_size(Json *json) {
+    return prv_token(json, json->index).size;
+}
 
-        if (linked_list_count(json->marks) == 0) {
-            free(json->marks);
-            json->marks = NULL;
-        }
+JsonMark json_mark(Json *json) {
+    return (JsonMark) { .index = json->index, .depth = json->num_frames };
+}
+
+// Key indexes made since the mark belong to objects inside it, so they're
+// dropped and json_seek() looks in the marked object's index again.
+void json_reset(Json *json, JsonMark mark) {
+    json->index = mark.index;
+    if (mark.depth < json->num_frames) json->num_frames = mark.depth;
+    while (json->num_segments > 0 && json->segments[json->num_segments - 1].base > mark.index) {
+        json->num_tokens = json->segments[--json->num_segments].base;
     }
 }
 
@@ -223,15 +728,113 @@ void json_advance(Json *json) {
 }
 
 void json_skip_tree(Json *json) {
-    jsmntok_t *tok = prv_json_next(json);
-    if (tok->type == JSMN_ARRAY) {
-        int size = tok->size;
-        for (int i = 0; i < size; i++) json_skip_tree(json);
-    } else if (tok-> type == JSMN_OBJECT) {
-        int size = tok->size;
-        for (int i = 0; i < size; i++) {
-            tok = prv_json_next(json);
-            json_skip_tree(json);
+    json->index = json->ends[json->index + 1];
+}
+
+static void prv_write(char *out, size_t *len, const char *s, size_t n) {
+    if (out) memcpy(out + *len, s, n);
+    *len += n;
+}
+
+// Writes the JSON text of the compiled token i and its subtree to out, or
+// only counts it if out is NULL. Strings are kept raw in the pool, so the
+// text reads back exactly as the compiled tokens do. Returns the index after
+// the subtree.
+static int16_t prv_write_tree(Json *json, int16_t i, char *out, size_t *len) {
+    jsmntok_t tok = prv_token(json, i);
+    int16_t next = i + 1;
+    switch (tok.type) {
+        case JSMN_OBJECT:
+        case JSMN_ARRAY:
+            prv_write(out, len, tok.type == JSMN_OBJECT ? "{" : "[", 1);
+            for (int j = 0; j < tok.size; j++) {
+                if (j > 0) prv_write(out, len, ",", 1);
+                next = prv_write_tree(json, next, out, len);
+            }
+            prv_write(out, len, tok.type == JSMN_OBJECT ? "}" : "]", 1);
+            return next;
+        case JSMN_STRING:
+            prv_write(out, len, "\"", 1);
+            prv_write(out, len, json->buf + tok.start, tok.end - tok.start);
+            prv_write(out, len, "\"", 1);
+            // A key, followed by its value.
+            if (tok.size > 0) {
+                prv_write(out, len, ":", 1);
+                next = prv_write_tree(json, next, out, len);
+            }
+            return next;
+        default:
+            prv_write(out, len, json->buf + tok.start, tok.end - tok.start);
+            return next;
+    }
+}
+
+char *json_copy_tree(Json *json) {
+    if (json->packed) {
+        size_t len = 0;
+        prv_write_tree(json, json->index, NULL, &len);
+        char *s = malloc(sizeof(char) * (len + 1));
+        len = 0;
+        prv_write_tree(json, json->index, s, &len);
+        s[len] = '\0';
+        return s;
+    }
+
+    jsmntok_t *tok = &json->tokens[json->index];
+    size_t len = tok->end - tok->start;
+    char *s = malloc(sizeof(char) * (len + 1));
+    if (json->buf) memcpy(s, json->buf + tok->start, len);
+    else resource_load_byte_range(json->handle, tok->start, (uint8_t *) s, len);
+    s[len] = '\0';
+    return s;
+}
+
+void json_index(Json *json) {
+    if (json->handle) prv_stream_expand(json);
+    int16_t object = json->index;
+    struct KeyFrame *top = json->num_frames > 0 ? &json->frames[json->num_frames - 1] : NULL;
+    if (top && top->object == object) return;
+
+    // Growing the frames moves top.
+    int16_t start = top ? top->start + top->count : 0;
+    if (json->num_frames == json->frames_size) {
+        json->frames_size = json->frames_size ? json->frames_size * 2 : 4;
+        json->frames = realloc(json->frames, sizeof(struct KeyFrame) * json->frames_size);
+        heap_peak_sample();
+    }
+    int16_t size = json_get_size(json);
+    if (start + size > json->keys_size) {
+        json->keys_size = start + size < 8 ? 8 : start + size;
+        json->keys = realloc(json->keys, sizeof(int16_t) * json->keys_size);
+        heap_peak_sample();
+    }
+
+    for (int16_t i = 0; i < size; i++) {
+        json_advance(json);
+        json->keys[start + i] = json->index;
+        json_skip_tree(json);
+    }
+    json->frames[json->num_frames++] = (struct KeyFrame) { .object = object, .start = start, .count = size };
+
+    json->index = object;
+}
+
+bool json_seek(Json *json, const char *key) {
+    if (json->num_frames == 0) return false;
+
+    struct KeyFrame *frame = &json->frames[json->num_frames - 1];
+    size_t len = strlen(key);
+    for (int16_t i = frame->start; i < frame->start + frame->count; i++) {
+        jsmntok_t tok = prv_token(json, json->keys[i]);
+        if ((size_t) (tok.end - tok.start) != len) continue;
+        if (strncmp(prv_token_text(json, &tok), key, len) == 0) {
+            json->index = json->keys[i];
+            return true;
         }
     }
+    return false;
+}
+
+bool json_string_eq(JsonString s, const char *t) {
+    return s.str != NULL && strncmp(s.str, t, s.len) == 0 && t[s.len] == '\0';
 }
@@ -1,365 +1,1087 @@
 #include <pebble.h>
+#include "arena.h"
+#include "bindings.h"
 #include "dict.h"
-#include "stack.h"
+#include "font-cache.h"
+#include "heap-peak.h"
+#include "json-internals.h"
+#include "keywords.h"
+#include "profile.h"
+#include "resource-cache.h"
 #include "standard-types.h"
 #include "layout-internals.h"
 #include "pebble-json.h"
 #include "pebble-layout.h"
 
-#define eq(s, t) (strncmp(s, t, strlen(s)) == 0)
-
 struct Layout {
+    Arena *arena;
     Layer *root;
+    // Layouts created from a template use the types, fonts and resources of
+    // the layout the template was made with.
+    Layout *prototype;
     Dict *types;
+    // The standard types by the index compiled layouts give them.
+    struct TypeData *standard_types[STANDARD_TYPE_COUNT];
     Dict *ids;
     Dict *fonts;
     Dict *resource_ids;
-    Stack *layers;
+    // Shared with the prototype, if there is one. The resources a layout
+    // made from a template takes are listed in acquired and given back to
+    // the prototype's cache when it's destroyed.
+    ResourceCache *resources;
+    struct Acquired *acquired;
+    struct LayerList *layers;
+    // The record of the layer whose properties are being parsed.
+    struct LayerList *parsing;
+    uint16_t parsing_index;
+    Bindings *bindings;
+    // The lazy node whose layers are being built or patched, so resources
+    // and bindings taken meanwhile can be released with it.
+    struct LazyNode *scope;
+    struct LazyNode *lazies;
+    Dict *lazy_ids;
+    bool eager;
+    bool patching;
+    // Footprint of the last parse. The JSON is gone by the time anyone asks.
+    size_t json_bytes;
+    size_t token_bytes;
+    size_t parse_peak;
 };
 
-struct LayerData {
-    TypeFuncs type_funcs;
+// A "lazy" node is parsed as an empty placeholder. Its JSON is kept and only
+// turned into layers when one of its IDs is looked up or it is materialized.
+struct LazyNode {
+    struct LazyNode *next;
+    char *json;
+    Layer *placeholder;
+    Layer *layer;
+    struct LayerList *layers;
+    struct Acquired *resources;
+    Dict *ids;
+};
+
+struct Acquired {
+    struct Acquired *next;
     void *object;
 };
 
+// A layer of a template, with everything that doesn't depend on the
+// instance worked out. Nodes are stored depth first, each followed by its
+// children. Standard types keep their properties already read; other types
+// parse the JSON at mark for every instance.
+struct TemplateNode {
+    struct TypeData *type;
+    GRect frame;
+    JsonMark mark;
+    JsonString id;
+    void *properties;
+    // -1 when the JSON doesn't set them.
+    int8_t clips;
+    int8_t hidden;
+    uint16_t num_children;
+};
+
+struct LayoutTemplate {
+    Layout *layout;
+    Json *json;
+    struct TemplateNode *nodes;
+    uint16_t num_nodes;
+    uint16_t capacity;
+};
+
 struct TypeData {
     TypeFuncs type_funcs;
     const char *parent_type;
+    // The type reads its own "layers" instead of having them built.
+    bool container;
+    TypeCompileFunc compile;
+    TypeInstanceFunc instance;
+};
+
+struct LayerData {
+    struct TypeData *type;
+    void *object;
+    // Text copied from the layout for the layer to show. Text the app sets
+    // itself stays the app's.
+    char *text;
+};
+
+// Layer records live inline in one growing array, destroyed last to first.
+// The array moves as it grows, so IDs map to an index rather than a record,
+// and a record is looked up again by index after anything that can add
+// layers. It stays on the heap even with an arena, which can't grow a block
+// in place and would keep every outgrown copy.
+struct LayerList {
+    struct LayerData *items;
+    uint16_t count;
+    uint16_t capacity;
 };
 
+// A custom font is only loaded once a layer uses it.
 struct FontInfo {
+    uint32_t resource_id;
     GFont font;
-    bool system;
 };
 
+// Sorted by name for binary search. The fonts are looked up the first time
+// they're used and shared by every layout.
+static const struct {
+    const char *name;
+    const char *key;
+} s_system_fonts[] = {
+    { "BITHAM_18_LIGHT_SUBSET", FONT_KEY_BITHAM_18_LIGHT_SUBSET },
+    { "BITHAM_30_BLACK", FONT_KEY_BITHAM_30_BLACK },
+    { "BITHAM_34_LIGHT_SUBSET", FONT_KEY_BITHAM_34_LIGHT_SUBSET },
+    { "BITHAM_34_MEDIUM_NUMBERS", FONT_KEY_BITHAM_34_MEDIUM_NUMBERS },
+    { "BITHAM_42_BOLD", FONT_KEY_BITHAM_42_BOLD },
+    { "BITHAM_42_LIGHT", FONT_KEY_BITHAM_42_LIGHT },
+    { "BITHAM_42_MEDIUM_NUMBERS", FONT_KEY_BITHAM_42_MEDIUM_NUMBERS },
+    { "DROID_SERIF_28_BOLD", FONT_KEY_DROID_SERIF_28_BOLD },
+    { "GOTHIC_09", FONT_KEY_GOTHIC_09 },
+    { "GOTHIC_14", FONT_KEY_GOTHIC_14 },
+    { "GOTHIC_14_BOLD", FONT_KEY_GOTHIC_14_BOLD },
+    { "GOTHIC_18", FONT_KEY_GOTHIC_18 },
+    { "GOTHIC_18_BOLD", FONT_KEY_GOTHIC_18_BOLD },
+    { "GOTHIC_24", FONT_KEY_GOTHIC_24 },
+    { "GOTHIC_24_BOLD", FONT_KEY_GOTHIC_24_BOLD },
+    { "GOTHIC_28", FONT_KEY_GOTHIC_28 },
+    { "GOTHIC_28_BOLD", FONT_KEY_GOTHIC_28_BOLD },
+    { "LECO_20_BOLD_NUMBERS", FONT_KEY_LECO_20_BOLD_NUMBERS },
+    { "LECO_26_BOLD_NUMBERS_AM_PM", FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM },
+    { "LECO_28_LIGHT_NUMBERS", FONT_KEY_LECO_28_LIGHT_NUMBERS },
+    { "LECO_32_BOLD_NUMBERS", FONT_KEY_LECO_32_BOLD_NUMBERS },
+    { "LECO_36_BOLD_NUMBERS", FONT_KEY_LECO_36_BOLD_NUMBERS },
+    { "LECO_38_BOLD_NUMBERS", FONT_KEY_LECO_38_BOLD_NUMBERS },
+    { "LECO_42_NUMBERS", FONT_KEY_LECO_42_NUMBERS },
+    { "ROBOTO_BOLD_SUBSET_49", FONT_KEY_ROBOTO_BOLD_SUBSET_49 },
+    { "ROBOTO_CONDENSED_21", FONT_KEY_ROBOTO_CONDENSED_21 },
+};
+
+static GFont s_system_font_cache[ARRAY_LENGTH(s_system_fonts)];
+
 static struct TypeData NO_TYPE_SENTINAL;
+static struct TypeData PLACEHOLDER_TYPE = { .type_funcs = { .destroy = (TypeDestroyFunc) layer_destroy } };
 
-static GRect prv_get_frame(Json *json) {
-    if (!json_is_object(json)) return GRectZero;
+GRect layout_next_rect(Json *json) {
+    GRect rect;
+    if (json_next_compiled_rect(json, &rect)) return rect;
 
-    GRect rect = GRectZero;
-    JsonMark *mark = json_mark(json);
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "frame")) {
-            json_advance(json);
-            int x = 0, y = 0, w = 0, h = 0;
-            if (json_is_array(json)) {
-                x = json_next_int(json);
-                y = json_next_int(json);
-                w = json_next_int(json);
-                h = json_next_int(json);
-            } else if (json_is_object(json)) {
-                size_t len = json_get_size(json);
-                for (size_t j = 0; j < len; j++) {
-                    char *value = json_next_string(json);
-                    if (value[0] == 'x') x = json_next_int(json);
-                    else if (value[0] == 'y') y = json_next_int(json);
-                    else if (value[0] == 'w') w = json_next_int(json);
-                    else if (value[0] == 'h') h = json_next_int(json);
-                    else json_skip_tree(json);
-                    free(value);
-                }
-            }
-            rect = GRect(x, y, w, h);
-        } else {
-            json_skip_tree(json);
+    json_advance(json);
+    int x = 0, y = 0, w = 0, h = 0;
+    if (json_is_array(json)) {
+        x = json_next_int(json);
+        y = json_next_int(json);
+        w = json_next_int(json);
+        h = json_next_int(json);
+    } else if (json_is_object(json)) {
+        size_t len = json_get_size(json);
+        for (size_t j = 0; j < len; j++) {
+            JsonString key = json_next_string_view(json);
+            char c = key.len > 0 ? key.str[0] : '\0';
+            if (c == 'x') x = json_next_int(json);
+            else if (c == 'y') y = json_next_int(json);
+            else if (c == 'w') w = json_next_int(json);
+            else if (c == 'h') h = json_next_int(json);
+            else json_skip_tree(json);
         }
-        free(key);
     }
+    return GRect(x, y, w, h);
+}
 
-    json_reset(json, mark);
-    return rect;
+static GRect prv_get_frame(Json *json) {
+    return json_seek(json, "frame") ? layout_next_rect(json) : GRectZero;
 }
 
-static struct TypeData *prv_get_type_data(Dict *types, Json *json) {
-    if (!json_is_object(json)) return NULL;
+// Layouts made from a template, and any made from those, use the types of
+// the first layout.
+static Layout *prv_types_owner(Layout *layout) {
+    while (layout->prototype) layout = layout->prototype;
+    return layout;
+}
 
-    struct TypeData *type_data = NULL;
-    JsonMark *mark = json_mark(json);
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "type")) {
-            char *type = json_next_string(json);
-            if (!dict_contains(types, type)) {
-                APP_LOG(APP_LOG_LEVEL_WARNING, "Type %s does not exist. Skipping layer.", type);
-                type_data = &NO_TYPE_SENTINAL;
-            } else {
-                type_data = dict_get(types, type);
-            }
-            free(type);
-        } else {
-            json_skip_tree(json);
+static struct TypeData *prv_get_type_data(Layout *layout, Json *json) {
+    if (!json_seek(json, "type")) return dict_get(layout->types, "Layer");
+
+    uint8_t standard;
+    if (json_next_compiled_type(json, &standard)) {
+        bool known = standard < STANDARD_TYPE_COUNT;
+        struct TypeData *type_data = known ? prv_types_owner(layout)->standard_types[standard] : NULL;
+        if (!type_data) {
+            APP_LOG(APP_LOG_LEVEL_WARNING, "Type %s does not exist. Skipping layer.",
+                    known ? STANDARD_TYPE_NAMES[standard] : "(unknown)");
+            type_data = &NO_TYPE_SENTINAL;
         }
-        free(key);
+        return type_data;
     }
 
-    if (type_data == NULL) type_data = dict_get(types, "Layer");
+    JsonString type = json_next_string_view(json);
+    struct TypeData *type_data = dict_get_n(layout->types, type.str, type.len);
+    if (!type_data) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "Type %.*s does not exist. Skipping layer.", (int) type.len, type.str);
+        type_data = &NO_TYPE_SENTINAL;
+    }
 
-    json_reset(json, mark);
     return type_data;
 }
 
 static bool prv_eval_capabilities(Json *json) {
+    if (!json_seek(json, "capabilities")) return true;
+
+    json_advance(json);
+    if (!json_is_array(json)) return true;
+
     bool has_capability = true;
+    size_t len = json_get_size(json);
+    for (size_t j = 0; j < len; j++) {
+        JsonString t = json_next_string_view(json);
+        bool negated = t.len > 4 && strncmp(t.str, "NOT_", 4) == 0;
+        if (negated) {
+            t.str += 4;
+            t.len -= 4;
+        }
+        bool b = false;
+        switch (keyword_lookup(t)) {
+            case KEYWORD_PLATFORM_APLITE: b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, true, false, false, false, false); break;
+            case KEYWORD_PLATFORM_BASALT: b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, false, true, false, false, false); break;
+            case KEYWORD_PLATFORM_CHALK: b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, false, false, true, false, false); break;
+            case KEYWORD_PLATFORM_DIORITE: b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, false, false, false, true, false); break;
+            case KEYWORD_BW: b = PBL_IF_BW_ELSE(true, false); break;
+            case KEYWORD_COLOR: b = PBL_IF_COLOR_ELSE(true, false); break;
+            case KEYWORD_HEALTH: b = PBL_IF_HEALTH_ELSE(true, false); break;
+            case KEYWORD_RECT: b = PBL_IF_RECT_ELSE(true, false); break;
+            case KEYWORD_ROUND: b = PBL_IF_ROUND_ELSE(true, false); break;
+            case KEYWORD_MICROPHONE: b = PBL_IF_MICROPHONE_ELSE(true, false); break;
+            case KEYWORD_SMARTSTRAP: b = PBL_IF_SMARTSTRAP_ELSE(true, false); break;
+            default: break;
+        }
+        has_capability = has_capability && (negated ? !b : b);
+    }
 
-    JsonMark *mark = json_mark(json);
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "capabilities")) {
+    return has_capability;
+}
+
+// Only IDs that materializing the node would create: layers that fail their
+// capabilities or have an unknown type are skipped with their children, and
+// the layers of a container type's template are its own.
+static void prv_add_lazy_ids(Layout *layout, Json *json, struct LazyNode *lazy) {
+    json_index(json);
+    JsonMark node = json_mark(json);
+    if (!prv_eval_capabilities(json)) return;
+    json_reset(json, node);
+
+    struct TypeData *type_data = dict_get(layout->types, "Layer");
+    if (json_seek(json, "type")) {
+        JsonString type = json_next_string_view(json);
+        type_data = dict_get_n(layout->types, type.str, type.len);
+        if (!type_data) return;
+    }
+    json_reset(json, node);
+
+    if (json_seek(json, "id")) {
+        JsonString id = json_next_string_view(json);
+        if (id.str && !dict_get_n(layout->lazy_ids, id.str, id.len)) {
+            dict_put(layout->lazy_ids, arena_strndup(layout->arena, id.str, id.len), lazy);
+        }
+    }
+
+    json_reset(json, node);
+    if (!type_data->container && json_seek(json, "layers")) {
+        json_advance(json);
+        size_t len = json_is_array(json) ? json_get_size(json) : 0;
+        for (size_t j = 0; j < len; j++) {
+            JsonMark mark = json_mark(json);
             json_advance(json);
-            if (!json_is_array(json)) continue;
-            size_t len = json_get_size(json);
-            for (size_t j = 0; j < len; j++) {
-                char *s = json_next_string(json);
-                bool negated = strncmp(s, "NOT_", 4) == 0;
-                char *t = s + (negated ? 4 : 0);
-                bool b = false;
-                if (eq(t, "PLATFORM_APLITE")) b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, true, false, false, false, false);
-                else if (eq(t, "PLATFORM_BASALT")) b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, false, true, false, false, false);
-                else if (eq(t, "PLATFORM_CHALK")) b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, false, false, true, false, false);
-                else if (eq(t, "PLATFORM_DIORITE")) b = PBL_PLATFORM_SWITCH(PBL_PLATFORM_TYPE_CURRENT, false, false, false, true, false);
-                else if (eq(t, "BW")) b = PBL_IF_BW_ELSE(true, false);
-                else if (eq(t, "COLOR")) b = PBL_IF_COLOR_ELSE(true, false);
-                else if (eq(t, "HEALTH")) b = PBL_IF_HEALTH_ELSE(true, false);
-                else if (eq(t, "RECT")) b= PBL_IF_RECT_ELSE(true, false);
-                else if (eq(t, "ROUND")) b = PBL_IF_ROUND_ELSE(true, false);
-                else if (eq(t, "MICROPHONE")) b = PBL_IF_MICROPHONE_ELSE(true, false);
-                else if (eq(t, "SMARTSTRAP")) b = PBL_IF_SMARTSTRAP_ELSE(true, false);
-                has_capability = has_capability && (negated ? !b : b);
-                free(s);
-            }
-        } else {
+            if (json_is_object(json)) prv_add_lazy_ids(layout, json, lazy);
+            json_reset(json, mark);
             json_skip_tree(json);
         }
-        free(key);
     }
+}
 
-    json_reset(json, mark);
-    return has_capability;
+static struct LayerList *prv_layer_list_create(void) {
+    struct LayerList *list = malloc(sizeof(struct LayerList));
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    return list;
 }
 
-static Layer *prv_create_layer(Layout *layout, Json *json) {
-    if (!json_is_object(json)) return NULL;
-    if (!prv_eval_capabilities(json)) return NULL;
+// Returns the index of the new record.
+static uint16_t prv_push_layer(struct LayerList *list, struct TypeData *type, void *object) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->items = realloc(list->items, sizeof(struct LayerData) * list->capacity);
+        heap_peak_sample();
+    }
+    struct LayerData *data = &list->items[list->count];
+    data->type = type;
+    data->object = object;
+    data->text = NULL;
+    return list->count++;
+}
 
-    struct TypeData *type_data = prv_get_type_data(layout->types, json);
-    if (type_data == &NO_TYPE_SENTINAL) return NULL;
-    TypeFuncs type_funcs = type_data->type_funcs;
+// IDs store index + 1, so a missing ID still reads as NULL. A lazy node's
+// IDs are dropped each time it's dematerialized, so they go on the heap.
+static void prv_put_id(Layout *layout, JsonString id, uint16_t index) {
+    if (!id.str || dict_get_n(layout->ids, id.str, id.len)) return;
+    Arena *arena = layout->scope ? NULL : layout->arena;
+    dict_put(layout->ids, arena_strndup(arena, id.str, id.len), (void *) ((uintptr_t) index + 1));
+}
 
-    struct LayerData *data = malloc(sizeof(struct LayerData));
-    stack_push(layout->layers, data);
-    data->type_funcs = type_funcs;
+static struct LayerData *prv_get_id(Dict *ids, struct LayerList *list, const char *id, size_t len) {
+    uintptr_t index = (uintptr_t) dict_get_n(ids, id, len);
+    return index ? &list->items[index - 1] : NULL;
+}
 
-    GRect frame = prv_get_frame(json);
-    data->object = type_funcs.create(frame);
+static Layer *prv_create_lazy(Layout *layout, Json *json) {
+    char *text = json_copy_tree(json);
+    if (!text) return NULL;
+
+    struct LazyNode *lazy = arena_alloc(layout->arena, sizeof(struct LazyNode));
+    lazy->json = text;
+    lazy->placeholder = layer_create(GRectZero);
+    lazy->layer = NULL;
+    lazy->layers = NULL;
+    lazy->resources = NULL;
+    lazy->ids = NULL;
+    lazy->next = layout->lazies;
+    layout->lazies = lazy;
+
+    prv_push_layer(layout->layers, &PLACEHOLDER_TYPE, lazy->placeholder);
+
+    prv_add_lazy_ids(layout, json, lazy);
+    return lazy->placeholder;
+}
+
+static Layer *prv_get_layer(struct LayerData *data) {
+    TypeFuncs *type_funcs = &data->type->type_funcs;
+    if (type_funcs->get_layer) return type_funcs->get_layer(data->object);
+    return (Layer *) data->object; // The object is a Layer
+}
+
+// Runs the type's parse functions and the common flags over the indexed node
+// at the cursor, leaving the cursor on the node. A patch only changes the
+// properties it mentions.
+static void prv_parse_properties(Layout *layout, Json *json, struct LayerList *list, uint16_t index, bool patch) {
+    JsonMark node = json_mark(json);
+    struct TypeData *type_data = list->items[index].type;
+    void *object = list->items[index].object;
+    struct LayerList *parsing = layout->parsing;
+    uint16_t parsing_index = layout->parsing_index;
+    bool patching = layout->patching;
+    layout->parsing = list;
+    layout->parsing_index = index;
+    layout->patching = patch;
 
     if (type_data->parent_type) {
         struct TypeData *parent_type = dict_get(layout->types, type_data->parent_type);
         if (parent_type) {
-            JsonMark *mark = json_mark(json);
-            parent_type->type_funcs.parse(layout, json, type_data->type_funcs.cast(data->object));
-            json_reset(json, mark);
+            parent_type->type_funcs.parse(layout, json, type_data->type_funcs.cast(object));
+            json_reset(json, node);
         }
     }
 
-    if (type_funcs.parse) {
-        JsonMark *mark = json_mark(json);
-        type_funcs.parse(layout, json, data->object);
-        json_reset(json, mark);
+    if (type_data->type_funcs.parse) {
+        type_data->type_funcs.parse(layout, json, object);
+        json_reset(json, node);
     }
 
-    Layer *layer = NULL;
-    if (type_funcs.get_layer) layer = type_funcs.get_layer(data->object);
-    else layer = (Layer *) data->object; // The object is a Layer
+    Layer *layer = prv_get_layer(&list->items[index]);
+    if (json_seek(json, "clips")) layer_set_clips(layer, json_next_bool(json));
+    if (json_seek(json, "hidden")) layer_set_hidden(layer, json_next_bool(json));
+    json_reset(json, node);
 
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "id")) {
-            char *id = json_next_string(json);
-            dict_put(layout->ids, id, data->object);
-        } else if (eq(key, "layers")) {
+    layout->parsing = parsing;
+    layout->parsing_index = parsing_index;
+    layout->patching = patching;
+}
+
+static Layer *prv_create_layer(Layout *layout, Json *json, bool can_defer) {
+    if (!json_is_object(json)) return NULL;
+
+    // Index the node's keys once; every phase below seeks into the index
+    // instead of walking the object again.
+    json_index(json);
+    JsonMark node = json_mark(json);
+    PROFILE_START(LayoutPhaseCapabilities);
+    bool visible = prv_eval_capabilities(json);
+    PROFILE_END(LayoutPhaseCapabilities);
+    if (!visible) return NULL;
+
+    if (can_defer && !layout->eager && json_seek(json, "lazy") && json_next_bool(json)) {
+        json_reset(json, node);
+        Layer *placeholder = prv_create_lazy(layout, json);
+        if (placeholder) return placeholder;
+    }
+    json_reset(json, node);
+
+    PROFILE_START(LayoutPhaseTypeLookup);
+    struct TypeData *type_data = prv_get_type_data(layout, json);
+    PROFILE_END(LayoutPhaseTypeLookup);
+    if (type_data == &NO_TYPE_SENTINAL) return NULL;
+
+    PROFILE_START(LayoutPhaseFrame);
+    GRect frame = prv_get_frame(json);
+    PROFILE_END(LayoutPhaseFrame);
+    json_reset(json, node);
+
+    PROFILE_START(LayoutPhaseCreate);
+    uint16_t index = prv_push_layer(layout->layers, type_data, type_data->type_funcs.create(frame));
+    PROFILE_END(LayoutPhaseCreate);
+
+    PROFILE_START(LayoutPhaseParse);
+    prv_parse_properties(layout, json, layout->layers, index, false);
+    PROFILE_END(LayoutPhaseParse);
+    Layer *layer = prv_get_layer(&layout->layers->items[index]);
+
+    if (json_seek(json, "id")) prv_put_id(layout, json_next_string_view(json), index);
+
+    if (!type_data->container && json_seek(json, "layers")) {
+        PROFILE_START(LayoutPhaseChildren);
+        json_advance(json);
+        size_t len = json_is_array(json) ? json_get_size(json) : 0;
+        for (size_t j = 0; j < len; j++) {
+            JsonMark mark = json_mark(json);
             json_advance(json);
-            size_t len = json_get_size(json);
-            for (size_t j = 0; j < len; j++) {
-                json_advance(json);
-                Layer *child = prv_create_layer(layout, json);
-                if (child) layer_add_child(layer, child);
-            }
-        } else if (eq(key, "clips")) {
-            layer_set_clips(layer, json_next_bool(json));
-        } else if (eq(key, "hidden")) {
-            layer_set_hidden(layer, json_next_bool(json));
-        } else {
+            Layer *child = prv_create_layer(layout, json, true);
+            if (child) layer_add_child(layer, child);
+            json_reset(json, mark);
             json_skip_tree(json);
         }
-        free(key);
+        PROFILE_END(LayoutPhaseChildren);
     }
 
     return layer;
 }
 
-static void prv_add_system_font(Layout *layout, char *name, const char *font_key) {
-    FontInfo *font_info = malloc(sizeof(FontInfo));
-    font_info->font = fonts_get_system_font(font_key);
-    font_info->system = true;
-    dict_put(layout->fonts, name, font_info);
+Layout *layout_create(void) {
+    return layout_create_with_arena(0);
 }
 
-Layout *layout_create(void) {
-    Layout *layout = malloc(sizeof(Layout));
+static Layout *prv_layout_create(size_t size, Layout *prototype) {
+    Arena *arena = size > 0 ? arena_create(size) : NULL;
+    Layout *layout = arena_alloc(arena, sizeof(Layout));
+    layout->arena = arena;
     layout->root = NULL;
-    layout->types = dict_create();
-    layout->ids = dict_create();
-    layout->fonts = dict_create();
-    layout->resource_ids = dict_create();
-    layout->layers = stack_create();
+    layout->prototype = prototype;
+    layout->types = prototype ? prototype->types : dict_create(arena);
+    memset(layout->standard_types, 0, sizeof(layout->standard_types));
+    layout->ids = dict_create(arena);
+    layout->fonts = prototype ? prototype->fonts : dict_create(arena);
+    layout->resource_ids = prototype ? prototype->resource_ids : dict_create(arena);
+    layout->resources = prototype ? prototype->resources : resource_cache_create(arena);
+    layout->acquired = NULL;
+    layout->layers = prv_layer_list_create();
+    layout->parsing = NULL;
+    layout->parsing_index = 0;
+    layout->scope = NULL;
+    layout->bindings = bindings_create(arena);
+    layout->lazies = NULL;
+    layout->lazy_ids = dict_create(arena);
+    layout->eager = false;
+    layout->patching = false;
+    layout->json_bytes = 0;
+    layout->token_bytes = 0;
+    layout->parse_peak = 0;
+    return layout;
+}
 
+Layout *layout_create_with_arena(size_t size) {
+    Layout *layout = prv_layout_create(size, NULL);
     standard_types_add_default_type(layout);
+    return layout;
+}
 
-    prv_add_system_font(layout, "GOTHIC_18_BOLD", FONT_KEY_GOTHIC_18_BOLD);
-    prv_add_system_font(layout, "GOTHIC_24", FONT_KEY_GOTHIC_24);
-    prv_add_system_font(layout, "GOTHIC_09", FONT_KEY_GOTHIC_09);
-    prv_add_system_font(layout, "GOTHIC_14", FONT_KEY_GOTHIC_14);
-    prv_add_system_font(layout, "GOTHIC_14_BOLD", FONT_KEY_GOTHIC_14_BOLD);
-    prv_add_system_font(layout, "GOTHIC_18", FONT_KEY_GOTHIC_18);
-    prv_add_system_font(layout, "GOTHIC_24_BOLD", FONT_KEY_GOTHIC_24_BOLD);
-    prv_add_system_font(layout, "GOTHIC_28", FONT_KEY_GOTHIC_28);
-    prv_add_system_font(layout, "GOTHIC_28_BOLD", FONT_KEY_GOTHIC_28_BOLD);
-    prv_add_system_font(layout, "BITHAM_30_BLACK", FONT_KEY_BITHAM_30_BLACK);
-    prv_add_system_font(layout, "BITHAM_42_BOLD", FONT_KEY_BITHAM_42_BOLD);
-    prv_add_system_font(layout, "BITHAM_42_LIGHT", FONT_KEY_BITHAM_42_LIGHT);
-    prv_add_system_font(layout, "BITHAM_42_MEDIUM_NUMBERS", FONT_KEY_BITHAM_42_MEDIUM_NUMBERS);
-    prv_add_system_font(layout, "BITHAM_34_MEDIUM_NUMBERS", FONT_KEY_BITHAM_34_MEDIUM_NUMBERS);
-    prv_add_system_font(layout, "BITHAM_34_LIGHT_SUBSET", FONT_KEY_BITHAM_34_LIGHT_SUBSET);
-    prv_add_system_font(layout, "BITHAM_18_LIGHT_SUBSET", FONT_KEY_BITHAM_18_LIGHT_SUBSET);
-    prv_add_system_font(layout, "ROBOTO_CONDENSED_21", FONT_KEY_ROBOTO_CONDENSED_21);
-    prv_add_system_font(layout, "ROBOTO_BOLD_SUBSET_49", FONT_KEY_ROBOTO_BOLD_SUBSET_49);
-    prv_add_system_font(layout, "DROID_SERIF_28_BOLD", FONT_KEY_DROID_SERIF_28_BOLD);
-    prv_add_system_font(layout, "LECO_20_BOLD_NUMBERS", FONT_KEY_LECO_20_BOLD_NUMBERS);
-    prv_add_system_font(layout, "LECO_26_BOLD_NUMBERS_AM_PM", FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM);
-    prv_add_system_font(layout, "LECO_32_BOLD_NUMBERS", FONT_KEY_LECO_32_BOLD_NUMBERS);
-    prv_add_system_font(layout, "LECO_36_BOLD_NUMBERS", FONT_KEY_LECO_36_BOLD_NUMBERS);
-    prv_add_system_font(layout, "LECO_38_BOLD_NUMBERS", FONT_KEY_LECO_38_BOLD_NUMBERS);
-    prv_add_system_font(layout, "LECO_42_NUMBERS", FONT_KEY_LECO_42_NUMBERS);
-    prv_add_system_font(layout, "LECO_28_LIGHT_NUMBERS", FONT_KEY_LECO_28_LIGHT_NUMBERS);
+static void prv_set_root(Layout *layout, Layer *root) {
+    layout->root = root;
+    if (!root) return;
 
-    return layout;
+    GRect frame = layer_get_frame(root);
+    if (grect_equal(&frame, &GRectZero)) {
+        layer_set_frame(root, GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT));
+    }
 }
 
-static void prv_parse(Layout *layout, Json *json) {
+// Takes ownership of json. heap is heap_bytes_used() from before it was
+// created, so the peak covers the tokens and the layers built from them.
+static void prv_parse(Layout *layout, Json *json, HeapPeak peak) {
     if (json_has_next(json) && json_is_object(json)) {
-        layout->root = prv_create_layer(layout, json);
-        GRect frame = layer_get_frame(layout->root);
-        if (grect_equal(&frame, &GRectZero)) {
-            layer_set_frame(layout->root, GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT));
-        }
+        prv_set_root(layout, prv_create_layer(layout, json, false));
     } else {
         APP_LOG(APP_LOG_LEVEL_ERROR, "layout is not valid");
     }
+
+    // After the build, since key indexes and streamed tokens grow during it.
+    json_get_memory(json, &layout->json_bytes, &layout->token_bytes);
+    layout->parse_peak = heap_peak_end(peak);
+    json_destroy(json);
 }
 
 void layout_parse_resource(Layout *layout, uint32_t resource_id) {
-    Json *json = json_create_with_resource(resource_id);
-    prv_parse(layout, json);
-    json_destroy(json);
+    HeapPeak peak = heap_peak_start();
+    prv_parse(layout, json_create_with_resource(resource_id), peak);
+}
+
+void layout_parse_resource_streaming(Layout *layout, uint32_t resource_id) {
+    HeapPeak peak = heap_peak_start();
+    prv_parse(layout, json_create_with_resource_streaming(resource_id), peak);
+}
+
+void layout_parse_binary_resource(Layout *layout, uint32_t resource_id) {
+    HeapPeak peak = heap_peak_start();
+    Json *json = json_create_with_binary_resource(resource_id);
+    if (!json) {
+        heap_peak_end(peak);
+        return;
+    }
+    prv_parse(layout, json, peak);
 }
 
 void layout_parse(Layout *layout, const char *s) {
-    Json *json = json_create(s, false);
-    prv_parse(layout, json);
-    json_destroy(json);
+    HeapPeak peak = heap_peak_start();
+    prv_parse(layout, json_create(s, false), peak);
 }
 
 static bool prv_key_destroy_callback(char *key, void *value, void *context) {
-    free(key);
+    arena_free((Arena *) context, key);
     key = NULL;
     return true;
 }
 
 static bool prv_value_destroy_callback(char *key, void *value, void *context) {
-    free(value);
+    arena_free((Arena *) context, value);
     value = NULL;
     return true;
 }
 
 static bool prv_fonts_destroy_callback(char *key, void *value, void *context) {
     FontInfo *font_info = (FontInfo *) value;
-    if (!font_info->system) fonts_unload_custom_font(font_info->font);
+    font_cache_release(font_info->font);
     font_info->font = NULL;
-    free(font_info);
+    arena_free((Arena *) context, font_info);
     return true;
 }
 
+static void prv_destroy_layers(struct LayerList *layers) {
+    for (uint16_t i = layers->count; i > 0; i--) {
+        struct LayerData *layer_data = &layers->items[i - 1];
+        layer_data->type->type_funcs.destroy(layer_data->object);
+        free(layer_data->text);
+    }
+    free(layers->items);
+    free(layers);
+}
+
+static void prv_materialize(Layout *layout, struct LazyNode *lazy) {
+    if (lazy->layers) return;
+
+    struct LayerList *layers = layout->layers;
+    struct LazyNode *scope = layout->scope;
+    Dict *ids = layout->ids;
+    lazy->layers = layout->layers = prv_layer_list_create();
+    layout->scope = lazy;
+    lazy->ids = layout->ids = dict_create(NULL);
+    layout->eager = true;
+
+    Json *json = json_create(lazy->json, false);
+    lazy->layer = json_has_next(json) ? prv_create_layer(layout, json, false) : NULL;
+    json_destroy(json);
+
+    layout->layers = layers;
+    layout->scope = scope;
+    layout->ids = ids;
+    layout->eager = false;
+
+    if (lazy->layer) layer_insert_above_sibling(lazy->layer, lazy->placeholder);
+}
+
+static void prv_release_all(Layout *layout, struct Acquired **acquired) {
+    while (*acquired) {
+        struct Acquired *next = (*acquired)->next;
+        resource_cache_release(layout->resources, (*acquired)->object);
+        free(*acquired);
+        *acquired = next;
+    }
+}
+
+static void prv_dematerialize(Layout *layout, struct LazyNode *lazy) {
+    if (!lazy->layers) return;
+
+    if (lazy->layer) layer_remove_from_parent(lazy->layer);
+    lazy->layer = NULL;
+
+    bindings_unbind_scope(layout->bindings, lazy);
+    prv_destroy_layers(lazy->layers);
+    lazy->layers = NULL;
+
+    prv_release_all(layout, &lazy->resources);
+
+    dict_foreach(lazy->ids, prv_key_destroy_callback, NULL);
+    dict_destroy(lazy->ids);
+    lazy->ids = NULL;
+}
+
 void layout_destroy(Layout *layout) {
-    struct LayerData *layer_data = NULL;
-    while ((layer_data = stack_pop(layout->layers)) != NULL) {
-        layer_data->type_funcs.destroy(layer_data->object);
-        layer_data->object = NULL;
-        free(layer_data);
+    struct LazyNode *lazy = layout->lazies;
+    while (lazy) {
+        struct LazyNode *next = lazy->next;
+        prv_dematerialize(layout, lazy);
+        free(lazy->json);
+        arena_free(layout->arena, lazy);
+        lazy = next;
     }
+    layout->lazies = NULL;
 
-    stack_destroy(layout->layers);
-    layout->layers = NULL;
+    dict_foreach(layout->lazy_ids, prv_key_destroy_callback, layout->arena);
+    dict_destroy(layout->lazy_ids);
+    layout->lazy_ids = NULL;
 
-    dict_foreach(layout->resource_ids, prv_value_destroy_callback, NULL);
-    dict_destroy(layout->resource_ids);
-    layout->resource_ids = NULL;
+    bindings_destroy(layout->bindings);
+    layout->bindings = NULL;
 
-    dict_foreach(layout->fonts, prv_fonts_destroy_callback, NULL);
-    dict_destroy(layout->fonts);
-    layout->fonts = NULL;
+    prv_destroy_layers(layout->layers);
+    layout->layers = NULL;
+
+    prv_release_all(layout, &layout->acquired);
+    if (!layout->prototype) resource_cache_destroy(layout->resources);
+    layout->resources = NULL;
 
-    dict_foreach(layout->ids, prv_key_destroy_callback, NULL);
+    dict_foreach(layout->ids, prv_key_destroy_callback, layout->arena);
     dict_destroy(layout->ids);
     layout->ids = NULL;
 
-    dict_foreach(layout->types, prv_value_destroy_callback, NULL);
-    dict_destroy(layout->types);
+    if (!layout->prototype) {
+        dict_foreach(layout->resource_ids, prv_value_destroy_callback, layout->arena);
+        dict_destroy(layout->resource_ids);
+
+        dict_foreach(layout->fonts, prv_fonts_destroy_callback, layout->arena);
+        dict_destroy(layout->fonts);
+
+        dict_foreach(layout->types, prv_value_destroy_callback, layout->arena);
+        dict_destroy(layout->types);
+    }
+    layout->resource_ids = NULL;
+    layout->fonts = NULL;
     layout->types = NULL;
 
-    free(layout);
+    Arena *arena = layout->arena;
+    arena_free(arena, layout);
+    arena_destroy(arena);
 }
 
 void layout_add_type(Layout *layout, const char *type, TypeFuncs type_funcs, const char *parent_type) {
-    struct TypeData *data = malloc(sizeof(struct TypeData));
+    if (dict_contains(layout->types, type)) return;
+
+    struct TypeData *data = arena_alloc(layout->arena, sizeof(struct TypeData));
     memcpy(&data->type_funcs, &type_funcs, sizeof(TypeFuncs));
     data->parent_type = parent_type;
+    data->container = false;
+    data->compile = NULL;
+    data->instance = NULL;
     dict_put(layout->types, (char *) type, data);
+
+    for (int i = 0; i < STANDARD_TYPE_COUNT; i++) {
+        if (strcmp(type, STANDARD_TYPE_NAMES[i]) == 0) prv_types_owner(layout)->standard_types[i] = data;
+    }
+}
+
+void layout_add_container_type(Layout *layout, const char *type, TypeFuncs type_funcs) {
+    layout_add_type(layout, type, type_funcs, NULL);
+    struct TypeData *data = dict_get(layout->types, type);
+    data->container = true;
+}
+
+void layout_add_compiled_type(Layout *layout, const char *type, TypeFuncs type_funcs,
+                              TypeCompileFunc compile, TypeInstanceFunc instance) {
+    if (dict_contains(layout->types, type)) return;
+
+    layout_add_type(layout, type, type_funcs, NULL);
+    struct TypeData *data = dict_get(layout->types, type);
+    data->compile = compile;
+    data->instance = instance;
 }
 
 Layer *layout_get_layer(Layout *layout) {
     return layout->root;
 }
 
+static struct LayerData *prv_find_by_id(Layout *layout, const char *id, size_t len, struct LazyNode **lazy) {
+    *lazy = NULL;
+    struct LayerData *data = prv_get_id(layout->ids, layout->layers, id, len);
+    if (data) return data;
+
+    *lazy = dict_get_n(layout->lazy_ids, id, len);
+    if (!*lazy) return NULL;
+    prv_materialize(layout, *lazy);
+    return prv_get_id((*lazy)->ids, (*lazy)->layers, id, len);
+}
+
 void *layout_find_by_id(Layout *layout, const char *id) {
-    return dict_get(layout->ids, id);
+    struct LazyNode *lazy;
+    struct LayerData *data = prv_find_by_id(layout, id, strlen(id), &lazy);
+    return data ? data->object : NULL;
+}
+
+static void prv_apply(Layout *layout, Json *json, struct LayerData *data, struct LazyNode *lazy) {
+    json_index(json);
+    JsonMark node = json_mark(json);
+    if (json_seek(json, "frame")) layer_set_frame(prv_get_layer(data), layout_next_rect(json));
+    json_reset(json, node);
+
+    struct LazyNode *scope = layout->scope;
+    struct LayerList *list = lazy ? lazy->layers : layout->layers;
+    layout->scope = lazy;
+    prv_parse_properties(layout, json, list, data - list->items, true);
+    layout->scope = scope;
+
+    // Custom types keep their state in layer data, which the SDK can't see.
+    layer_mark_dirty(prv_get_layer(data));
+}
+
+void layout_apply(Layout *layout, const char *patch) {
+    Json *json = json_create(patch, false);
+    if (!json_has_next(json) || !json_is_object(json)) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "layout patch is not valid");
+        json_destroy(json);
+        return;
+    }
+
+    size_t size = json_get_size(json);
+    for (size_t i = 0; i < size; i++) {
+        JsonString id = json_next_string_view(json);
+        JsonMark mark = json_mark(json);
+        json_advance(json);
+        struct LazyNode *lazy = NULL;
+        struct LayerData *data = NULL;
+        if (id.str && json_is_object(json)) data = prv_find_by_id(layout, id.str, id.len, &lazy);
+        if (data) prv_apply(layout, json, data, lazy);
+        json_reset(json, mark);
+        json_skip_tree(json);
+    }
+
+    json_destroy(json);
+}
+
+static bool prv_compile_node(LayoutTemplate *layout_template, Json *json) {
+    if (!json_is_object(json)) return false;
+
+    Layout *layout = layout_template->layout;
+    JsonMark start = json_mark(json);
+    json_index(json);
+    JsonMark node = json_mark(json);
+    if (!prv_eval_capabilities(json)) return false;
+    json_reset(json, node);
+
+    struct TypeData *type_data = prv_get_type_data(layout, json);
+    if (type_data == &NO_TYPE_SENTINAL) return false;
+    json_reset(json, node);
+
+    if (layout_template->num_nodes == layout_template->capacity) {
+        layout_template->capacity = layout_template->capacity ? layout_template->capacity * 2 : 8;
+        layout_template->nodes = realloc(layout_template->nodes, sizeof(struct TemplateNode) * layout_template->capacity);
+    }
+    uint16_t i = layout_template->num_nodes++;
+    struct TemplateNode *template_node = &layout_template->nodes[i];
+    template_node->type = type_data;
+    template_node->frame = prv_get_frame(json);
+    template_node->mark = start;
+    template_node->id = (JsonString) { NULL, 0 };
+    template_node->properties = NULL;
+    template_node->clips = -1;
+    template_node->hidden = -1;
+    template_node->num_children = 0;
+    json_reset(json, node);
+    if (json_seek(json, "id")) template_node->id = json_next_string_view(json);
+    if (type_data->compile) {
+        template_node->properties = type_data->compile(layout, json);
+        json_reset(json, node);
+        if (json_seek(json, "clips")) template_node->clips = json_next_bool(json);
+        if (json_seek(json, "hidden")) template_node->hidden = json_next_bool(json);
+    }
+    json_reset(json, node);
+
+    if (!type_data->container && json_seek(json, "layers")) {
+        json_advance(json);
+        size_t len = json_is_array(json) ? json_get_size(json) : 0;
+        for (size_t j = 0; j < len; j++) {
+            JsonMark mark = json_mark(json);
+            json_advance(json);
+            // Compiling the child can move the array, so index it again.
+            if (prv_compile_node(layout_template, json)) layout_template->nodes[i].num_children++;
+            json_reset(json, mark);
+            json_skip_tree(json);
+        }
+    }
+    return true;
+}
+
+static LayoutTemplate *prv_template_create(Layout *layout, Json *json) {
+    LayoutTemplate *layout_template = malloc(sizeof(LayoutTemplate));
+    layout_template->layout = layout;
+    layout_template->json = json;
+    layout_template->nodes = NULL;
+    layout_template->num_nodes = 0;
+    layout_template->capacity = 0;
+
+    // The nodes are for new layers, even when a patch asks for the template.
+    bool patching = layout->patching;
+    layout->patching = false;
+    if (!json_has_next(json) || !prv_compile_node(layout_template, json)) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "layout template is not valid");
+    }
+    layout->patching = patching;
+    return layout_template;
+}
+
+LayoutTemplate *layout_template_create(Layout *layout, const char *s) {
+    size_t len = strlen(s);
+    char *copy = malloc(sizeof(char) * (len + 1));
+    memcpy(copy, s, len + 1);
+    return prv_template_create(layout, json_create(copy, true));
+}
+
+LayoutTemplate *layout_template_create_with_resource(Layout *layout, uint32_t resource_id) {
+    return prv_template_create(layout, json_create_with_resource(resource_id));
+}
+
+LayoutTemplate *layout_template_create_from_tree(Layout *layout, Json *json) {
+    char *text = json_copy_tree(json);
+    return text ? prv_template_create(layout, json_create(text, true)) : NULL;
+}
+
+GRect layout_template_get_frame(LayoutTemplate *layout_template) {
+    return layout_template->num_nodes > 0 ? layout_template->nodes[0].frame : GRectZero;
+}
+
+void layout_template_destroy(LayoutTemplate *layout_template) {
+    for (uint16_t i = 0; i < layout_template->num_nodes; i++) free(layout_template->nodes[i].properties);
+    json_destroy(layout_template->json);
+    free(layout_template->nodes);
+    free(layout_template);
+}
+
+// Standard types set the properties read when the template was made. Only
+// other types' parse functions read the JSON again.
+static Layer *prv_instantiate(Layout *layout, LayoutTemplate *layout_template, uint16_t *i) {
+    struct TemplateNode *node = &layout_template->nodes[(*i)++];
+    Json *json = layout_template->json;
+
+    uint16_t index = prv_push_layer(layout->layers, node->type, node->type->type_funcs.create(node->frame));
+
+    if (node->properties) {
+        layout->parsing = layout->layers;
+        layout->parsing_index = index;
+        node->type->instance(layout, node->properties, layout->layers->items[index].object);
+        layout->parsing = NULL;
+    } else {
+        json_reset(json, node->mark);
+        json_index(json);
+        prv_parse_properties(layout, json, layout->layers, index, false);
+    }
+    Layer *layer = prv_get_layer(&layout->layers->items[index]);
+    if (node->clips >= 0) layer_set_clips(layer, node->clips);
+    if (node->hidden >= 0) layer_set_hidden(layer, node->hidden);
+
+    prv_put_id(layout, node->id, index);
+
+    for (uint16_t j = 0; j < node->num_children; j++) {
+        layer_add_child(layer, prv_instantiate(layout, layout_template, i));
+    }
+    return layer;
+}
+
+Layout *layout_create_from_template(LayoutTemplate *layout_template, const char *overrides) {
+    Layout *layout = prv_layout_create(0, layout_template->layout);
+    if (layout_template->num_nodes == 0) return layout;
+
+    uint16_t i = 0;
+    prv_set_root(layout, prv_instantiate(layout, layout_template, &i));
+    if (overrides) layout_apply(layout, overrides);
+    return layout;
+}
+
+bool layout_materialize(Layout *layout, const char *id) {
+    return layout_find_by_id(layout, id) != NULL;
+}
+
+void layout_dematerialize(Layout *layout, const char *id) {
+    struct LazyNode *lazy = dict_get(layout->lazy_ids, id);
+    if (lazy) prv_dematerialize(layout, lazy);
+}
+
+static int prv_find_system_font(const char *name, size_t len) {
+    int lo = 0, hi = ARRAY_LENGTH(s_system_fonts) - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const char *s = s_system_fonts[mid].name;
+        int c = strncmp(s, name, len);
+        if (c == 0) {
+            if (s[len] == '\0') return mid;
+            c = 1;
+        }
+        if (c < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
 }
 
 void layout_add_font(Layout *layout, char *name, uint32_t resource_id) {
-    FontInfo *font_info = malloc(sizeof(FontInfo));
-    font_info->font = fonts_load_custom_font(resource_get_handle(resource_id));
-    font_info->system = false;
+    if (prv_find_system_font(name, strlen(name)) >= 0 || dict_contains(layout->fonts, name)) return;
+
+    FontInfo *font_info = arena_alloc(layout->arena, sizeof(FontInfo));
+    font_info->resource_id = resource_id;
+    font_info->font = NULL;
     dict_put(layout->fonts, name, font_info);
 }
 
-GFont layout_get_font(Layout *layout, const char *name) {
-    FontInfo *font_info = dict_get(layout->fonts, name);
-    return font_info ? font_info->font : NULL;
+GFont layout_get_font(Layout *layout, JsonString name) {
+    if (!name.str) return NULL;
+
+    int i = prv_find_system_font(name.str, name.len);
+    if (i >= 0) {
+        if (!s_system_font_cache[i]) s_system_font_cache[i] = fonts_get_system_font(s_system_fonts[i].key);
+        return s_system_font_cache[i];
+    }
+
+    FontInfo *font_info = dict_get_n(layout->fonts, name.str, name.len);
+    if (!font_info) return NULL;
+    if (!font_info->font) font_info->font = font_cache_get(font_info->resource_id);
+    return font_info->font;
 }
 
 void layout_add_resource(Layout *layout, char *name, uint32_t resource_id) {
-    uint32_t *rid = malloc(sizeof(uint32_t));
+    if (dict_contains(layout->resource_ids, name)) return;
+
+    uint32_t *rid = arena_alloc(layout->arena, sizeof(uint32_t));
     memcpy(rid, &resource_id, sizeof(uint32_t));
     dict_put(layout->resource_ids, name, rid);
 }
 
-uint32_t *layout_get_resource(Layout *layout, const char *name) {
-    return dict_get(layout->resource_ids, name);
+uint32_t *layout_get_resource(Layout *layout, JsonString name) {
+    return dict_get_n(layout->resource_ids, name.str, name.len);
+}
+
+// Where resources taken now have to be given back from, or NULL if the
+// cache is the layout's own and goes with it.
+static struct Acquired **prv_acquired_list(Layout *layout) {
+    if (layout->scope) return &layout->scope->resources;
+    return layout->prototype ? &layout->acquired : NULL;
+}
+
+static void *prv_acquired(Layout *layout, void *object) {
+    struct Acquired **list = prv_acquired_list(layout);
+    if (object && list) {
+        struct Acquired *acquired = malloc(sizeof(struct Acquired));
+        acquired->object = object;
+        acquired->next = *list;
+        *list = acquired;
+    }
+    return object;
+}
+
+GBitmap *layout_get_bitmap(Layout *layout, uint32_t *resource_id) {
+    return resource_id ? prv_acquired(layout, resource_cache_get_bitmap(layout->resources, *resource_id)) : NULL;
+}
+
+GBitmap *layout_get_sub_bitmap(Layout *layout, uint32_t *resource_id, GRect source) {
+    return resource_id ? prv_acquired(layout, resource_cache_get_sub_bitmap(layout->resources, *resource_id, source)) : NULL;
+}
+
+GDrawCommandImage *layout_get_pdc(Layout *layout, uint32_t *resource_id) {
+    return resource_id ? prv_acquired(layout, resource_cache_get_pdc(layout->resources, *resource_id)) : NULL;
+}
+
+char *layout_bind_text(Layout *layout, TextLayer *layer, char *template) {
+    return bindings_bind(layout->bindings, layer, template, layout->scope);
+}
+
+void layout_unbind_text(Layout *layout, TextLayer *layer) {
+    bindings_unbind(layout->bindings, layer);
+}
+
+bool layout_is_patching(Layout *layout) {
+    return layout->patching;
+}
+
+void layout_own_text(Layout *layout, char *text) {
+    struct LayerData *data = &layout->parsing->items[layout->parsing_index];
+    free(data->text);
+    data->text = text;
+}
+
+void layout_set_value(Layout *layout, const char *key, const char *value) {
+    bindings_set_value(layout->bindings, key, value);
+}
+
+static void prv_layer_list_stats(struct LayerList *list, LayoutStats *stats) {
+    stats->layer_data += sizeof(struct LayerList) + sizeof(struct LayerData) * list->capacity;
+    for (uint16_t i = 0; i < list->count; i++) {
+        if (list->items[i].text) stats->text += strlen(list->items[i].text) + 1;
+    }
+}
+
+static bool prv_key_stats_callback(char *key, void *value, void *context) {
+    *(size_t *) context += strlen(key) + 1;
+    return true;
+}
+
+static bool prv_font_stats_callback(char *key, void *value, void *context) {
+    *(size_t *) context += sizeof(FontInfo);
+    return true;
+}
+
+void layout_get_stats(Layout *layout, LayoutStats *stats) {
+    memset(stats, 0, sizeof(LayoutStats));
+    stats->json = layout->json_bytes;
+    stats->tokens = layout->token_bytes;
+    stats->parse_peak = layout->parse_peak;
+
+    prv_layer_list_stats(layout->layers, stats);
+    stats->text += bindings_text_used(layout->bindings);
+
+    stats->dicts = dict_memory_used(layout->ids) + dict_memory_used(layout->lazy_ids);
+    if (!layout->prototype) {
+        stats->dicts += dict_memory_used(layout->types) + dict_memory_used(layout->fonts) +
+            dict_memory_used(layout->resource_ids);
+        dict_foreach(layout->fonts, prv_font_stats_callback, &stats->fonts);
+    }
+    dict_foreach(layout->ids, prv_key_stats_callback, &stats->strings);
+    dict_foreach(layout->lazy_ids, prv_key_stats_callback, &stats->strings);
+    stats->strings += bindings_memory_used(layout->bindings);
+
+    for (struct LazyNode *lazy = layout->lazies; lazy; lazy = lazy->next) {
+        stats->layer_data += sizeof(struct LazyNode);
+        stats->strings += strlen(lazy->json) + 1;
+        if (!lazy->layers) continue;
+        prv_layer_list_stats(lazy->layers, stats);
+        stats->dicts += dict_memory_used(lazy->ids);
+        dict_foreach(lazy->ids, prv_key_stats_callback, &stats->strings);
+        for (struct Acquired *acquired = lazy->resources; acquired; acquired = acquired->next) {
+            stats->images += sizeof(struct Acquired);
+        }
+    }
+
+    for (struct Acquired *acquired = layout->acquired; acquired; acquired = acquired->next) {
+        stats->images += sizeof(struct Acquired);
+    }
+    if (!layout->prototype) stats->images += resource_cache_memory_used(layout->resources);
+    stats->total = sizeof(Layout) + stats->strings + stats->layer_data + stats->dicts +
+        stats->fonts + stats->images + stats->text;
+}
+
+void layout_release_resource(Layout *layout, void *object) {
+    if (!object) return;
+    struct Acquired **list = prv_acquired_list(layout);
+    if (list) {
+        for (struct Acquired **link = list; *link; link = &(*link)->next) {
+            if ((*link)->object != object) continue;
+            struct Acquired *acquired = *link;
+            *link = acquired->next;
+            free(acquired);
+            break;
+        }
+    }
+    resource_cache_release(layout->resources, object);
 }
 
 void layout_add_all_standard_types(Layout *layout) {
@@ -367,6 +1089,7 @@ void layout_add_all_standard_types(Layout *layout) {
     layout_add_bitmap_type(layout);
     layout_add_status_bar_type(layout);
     layout_add_pdc_type(layout);
+    layout_add_repeat_type(layout);
 }
 
 void layout_add_text_type(Layout *layout) {
@@ -384,3 +1107,7 @@ void layout_add_status_bar_type(Layout *layout) {
 void layout_add_pdc_type(Layout *layout) {
     standard_types_add_pdc_type(layout);
 }
+
+void layout_add_repeat_type(Layout *layout) {
+    standard_types_add_repeat_type(layout);
+}
@@ -0,0 +1,64 @@
+#include <pebble.h>
+#include "profile.h"
+
+#ifdef LAYOUT_PROFILE
+static const char *s_names[LayoutPhaseCount] = {
+    [LayoutPhaseTokenize] = "tokenize",
+    [LayoutPhaseCapabilities] = "capabilities",
+    [LayoutPhaseTypeLookup] = "type lookup",
+    [LayoutPhaseFrame] = "frame",
+    [LayoutPhaseCreate] = "create",
+    [LayoutPhaseParse] = "parse",
+    [LayoutPhaseChildren] = "children",
+};
+
+static LayoutPhaseStats s_phases[LayoutPhaseCount];
+// Milliseconds recorded across all phases. Only differences are used, so
+// it's never reset.
+static uint32_t s_recorded;
+
+static uint32_t prv_now(void) {
+    time_t s;
+    uint16_t ms = time_ms(&s, NULL);
+    return (uint32_t) s * 1000 + ms;
+}
+
+ProfileMark profile_start(void) {
+    return (ProfileMark) { .start = prv_now(), .recorded = s_recorded };
+}
+
+// Phases nest, since children builds whole layers, so each phase records
+// only its own time: whatever was recorded since it started belongs to the
+// phases inside it. Most calls take less than a millisecond, but the clock
+// ticks at a random point inside each one, so the sum over many calls is
+// still accurate.
+void profile_record(LayoutPhase phase, ProfileMark mark) {
+    uint32_t ms = prv_now() - mark.start - (s_recorded - mark.recorded);
+    s_phases[phase].calls++;
+    s_phases[phase].ms += ms;
+    s_recorded += ms;
+}
+#endif
+
+LayoutPhaseStats layout_profile_get(LayoutPhase phase) {
+#ifdef LAYOUT_PROFILE
+    if (phase < LayoutPhaseCount) return s_phases[phase];
+#endif
+    return (LayoutPhaseStats) { 0 };
+}
+
+void layout_profile_reset(void) {
+#ifdef LAYOUT_PROFILE
+    memset(s_phases, 0, sizeof(s_phases));
+#endif
+}
+
+void layout_profile_log(void) {
+#ifdef LAYOUT_PROFILE
+    for (int i = 0; i < LayoutPhaseCount; i++) {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "%-12s %6d calls %6d ms", s_names[i], (int) s_phases[i].calls, (int) s_phases[i].ms);
+    }
+#else
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "pebble-layout was built without LAYOUT_PROFILE");
+#endif
+}
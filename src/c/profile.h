@@ -0,0 +1,20 @@
+#pragma once
+#include <pebble-layout.h>
+
+// Building with -DLAYOUT_PROFILE times each parse phase. Without it these
+// expand to nothing.
+#ifdef LAYOUT_PROFILE
+typedef struct {
+    uint32_t start;
+    uint32_t recorded;
+} ProfileMark;
+
+ProfileMark profile_start(void);
+void profile_record(LayoutPhase phase, ProfileMark mark);
+
+#define PROFILE_START(phase) ProfileMark profile_start_##phase = profile_start()
+#define PROFILE_END(phase) profile_record(phase, profile_start_##phase)
+#else
+#define PROFILE_START(phase)
+#define PROFILE_END(phase)
+#endif
@@ -0,0 +1,156 @@
+#include <pebble.h>
+#include "resource-cache.h"
+
+typedef enum {
+    ResourceKindBitmap,
+    ResourceKindSubBitmap,
+    ResourceKindPdc
+} ResourceKind;
+
+struct Entry {
+    struct Entry *next;
+    uint32_t resource_id;
+    ResourceKind kind;
+    uint16_t refs;
+    void *object;
+    // Sub-bitmaps hold a reference to the atlas they point into.
+    GRect source;
+    struct Entry *parent;
+};
+
+struct ResourceCache {
+    Arena *arena;
+    struct Entry *entries;
+};
+
+ResourceCache *resource_cache_create(Arena *arena) {
+    ResourceCache *cache = arena_alloc(arena, sizeof(ResourceCache));
+    cache->arena = arena;
+    cache->entries = NULL;
+    return cache;
+}
+
+static void prv_destroy_object(struct Entry *entry) {
+    switch (entry->kind) {
+        case ResourceKindBitmap:
+        case ResourceKindSubBitmap: gbitmap_destroy(entry->object); break;
+        case ResourceKindPdc: gdraw_command_image_destroy(entry->object); break;
+    }
+    entry->object = NULL;
+}
+
+// Entries are kept newest first and a sub-bitmap is always newer than its
+// atlas, so walking the list frees every sub-bitmap before its pixels go.
+void resource_cache_destroy(ResourceCache *cache) {
+    struct Entry *entry = cache->entries;
+    while (entry) {
+        struct Entry *next = entry->next;
+        prv_destroy_object(entry);
+        free(entry);
+        entry = next;
+    }
+    cache->entries = NULL;
+    arena_free(cache->arena, cache);
+}
+
+static struct Entry *prv_find(ResourceCache *cache, uint32_t resource_id, ResourceKind kind, GRect source) {
+    for (struct Entry *entry = cache->entries; entry; entry = entry->next) {
+        if (entry->resource_id == resource_id && entry->kind == kind &&
+                (kind != ResourceKindSubBitmap || grect_equal(&entry->source, &source))) {
+            entry->refs += 1;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Entries come and go with the layers that use them, so they're on the heap
+// even when the cache is in an arena, which would never reclaim them.
+static struct Entry *prv_add(ResourceCache *cache, uint32_t resource_id, ResourceKind kind, void *object) {
+    struct Entry *entry = malloc(sizeof(struct Entry));
+    entry->resource_id = resource_id;
+    entry->kind = kind;
+    entry->refs = 1;
+    entry->object = object;
+    entry->source = GRectZero;
+    entry->parent = NULL;
+    entry->next = cache->entries;
+    cache->entries = entry;
+    return entry;
+}
+
+static struct Entry *prv_get(ResourceCache *cache, uint32_t resource_id, ResourceKind kind) {
+    struct Entry *entry = prv_find(cache, resource_id, kind, GRectZero);
+    if (entry) return entry;
+
+    void *object = NULL;
+    switch (kind) {
+        case ResourceKindBitmap: object = gbitmap_create_with_resource(resource_id); break;
+        case ResourceKindPdc: object = gdraw_command_image_create_with_resource(resource_id); break;
+        default: break;
+    }
+    return object ? prv_add(cache, resource_id, kind, object) : NULL;
+}
+
+GBitmap *resource_cache_get_bitmap(ResourceCache *cache, uint32_t resource_id) {
+    struct Entry *entry = prv_get(cache, resource_id, ResourceKindBitmap);
+    return entry ? entry->object : NULL;
+}
+
+GBitmap *resource_cache_get_sub_bitmap(ResourceCache *cache, uint32_t resource_id, GRect source) {
+    struct Entry *entry = prv_find(cache, resource_id, ResourceKindSubBitmap, source);
+    if (entry) return entry->object;
+
+    struct Entry *atlas = prv_get(cache, resource_id, ResourceKindBitmap);
+    if (!atlas) return NULL;
+    GBitmap *bitmap = gbitmap_create_as_sub_bitmap(atlas->object, source);
+    if (!bitmap) {
+        resource_cache_release(cache, atlas->object);
+        return NULL;
+    }
+
+    entry = prv_add(cache, resource_id, ResourceKindSubBitmap, bitmap);
+    entry->source = source;
+    entry->parent = atlas;
+    return bitmap;
+}
+
+GDrawCommandImage *resource_cache_get_pdc(ResourceCache *cache, uint32_t resource_id) {
+    struct Entry *entry = prv_get(cache, resource_id, ResourceKindPdc);
+    return entry ? entry->object : NULL;
+}
+
+// Bitmaps are counted by their pixel data and PDCs by their resource size,
+// which is what they take once loaded.
+size_t resource_cache_memory_used(ResourceCache *cache) {
+    size_t size = sizeof(ResourceCache);
+    for (struct Entry *entry = cache->entries; entry; entry = entry->next) {
+        size += sizeof(struct Entry);
+        switch (entry->kind) {
+            case ResourceKindBitmap:
+                size += gbitmap_get_bytes_per_row(entry->object) * gbitmap_get_bounds(entry->object).size.h;
+                break;
+            case ResourceKindPdc:
+                size += resource_size(resource_get_handle(entry->resource_id));
+                break;
+            default: break;
+        }
+    }
+    return size;
+}
+
+void resource_cache_release(ResourceCache *cache, void *object) {
+    if (!object) return;
+    for (struct Entry **link = &cache->entries; *link; link = &(*link)->next) {
+        struct Entry *entry = *link;
+        if (entry->object != object) continue;
+        if (--entry->refs == 0) {
+            *link = entry->next;
+            struct Entry *parent = entry->parent;
+            prv_destroy_object(entry);
+            free(entry);
+            if (parent) resource_cache_release(cache, parent->object);
+        }
+        return;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <pebble.h>
+#include "arena.h"
+
+typedef struct ResourceCache ResourceCache;
+
+// Each get takes a reference; release drops it and frees the image with the
+// last one. Destroying the cache frees everything it still holds.
+ResourceCache *resource_cache_create(Arena *arena);
+void resource_cache_destroy(ResourceCache *cache);
+GBitmap *resource_cache_get_bitmap(ResourceCache *cache, uint32_t resource_id);
+GBitmap *resource_cache_get_sub_bitmap(ResourceCache *cache, uint32_t resource_id, GRect source);
+GDrawCommandImage *resource_cache_get_pdc(ResourceCache *cache, uint32_t resource_id);
+void resource_cache_release(ResourceCache *cache, void *object);
+size_t resource_cache_memory_used(ResourceCache *cache);
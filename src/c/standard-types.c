@@ -1,13 +1,35 @@
 #include <pebble.h>
+#include "keywords.h"
 #include "layout-internals.h"
 #include "standard-types.h"
 
-#define eq(s, t) (strncmp(s, t, strlen(s)) == 0)
+const char *const STANDARD_TYPE_NAMES[STANDARD_TYPE_COUNT] = {
+    "Layer", "TextLayer", "BitmapLayer", "StatusBarLayer", "PdcLayer", "RepeatLayer"
+};
+
+// Each type reads its properties into a struct and then sets them, so a
+// parse and a layout created from a template set them the same way. `set`
+// has a bit for each property the JSON gives.
+enum {
+    PROPERTY_TEXT = 1 << 0,
+    PROPERTY_COLOR = 1 << 1,
+    PROPERTY_BACKGROUND = 1 << 2,
+    PROPERTY_FOREGROUND = 1 << 3,
+    PROPERTY_ALIGNMENT = 1 << 4,
+    PROPERTY_COMPOSITING = 1 << 5,
+    PROPERTY_SEPARATOR = 1 << 6,
+    PROPERTY_OFFSET = 1 << 7
+};
 
 struct DefaultLayerData {
     GColor color;
 };
 
+struct DefaultProperties {
+    uint8_t set;
+    GColor background;
+};
+
 static void prv_default_update_proc(Layer *layer, GContext *ctx) {
     struct DefaultLayerData *data = layer_get_data(layer);
     if (!gcolor_equal(data->color, GColorClear)) {
@@ -24,159 +46,271 @@ static void *prv_default_layer_create(GRect frame) {
     return layer;
 }
 
-static void prv_default_layer_parse(Layout *layout, Json *json, void *object) {
-    Layer *layer = (Layer *) object;
+static void prv_default_layer_read(Layout *layout, Json *json, struct DefaultProperties *props) {
+    props->set = 0;
+    if (json_seek(json, "background")) {
+        props->set |= PROPERTY_BACKGROUND;
+        props->background = json_next_color(json);
+    }
+}
+
+static void prv_default_layer_set(Layout *layout, const struct DefaultProperties *props, Layer *layer) {
     struct DefaultLayerData *data = layer_get_data(layer);
+    if (props->set & PROPERTY_BACKGROUND) data->color = props->background;
+}
 
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "background")) {
-            data->color = json_next_color(json);
-        } else {
-            json_skip_tree(json);
+static void prv_default_layer_parse(Layout *layout, Json *json, void *object) {
+    struct DefaultProperties props;
+    prv_default_layer_read(layout, json, &props);
+    prv_default_layer_set(layout, &props, (Layer *) object);
+}
+
+static void *prv_default_layer_compile(Layout *layout, Json *json) {
+    struct DefaultProperties *props = malloc(sizeof(struct DefaultProperties));
+    prv_default_layer_read(layout, json, props);
+    return props;
+}
+
+struct TextProperties {
+    uint8_t set;
+    // Owned by whoever holds the properties.
+    char *text;
+    GColor color;
+    GColor background;
+    GTextAlignment alignment;
+    GFont font;
+};
+
+static void prv_text_layer_read(Layout *layout, Json *json, struct TextProperties *props) {
+    props->set = 0;
+    props->text = NULL;
+    props->font = NULL;
+
+    if (json_seek(json, "text")) {
+        props->set |= PROPERTY_TEXT;
+        props->text = json_next_string(json);
+    }
+    if (json_seek(json, "color")) {
+        props->set |= PROPERTY_COLOR;
+        props->color = json_next_color(json);
+    }
+    if (json_seek(json, "background")) {
+        props->set |= PROPERTY_BACKGROUND;
+        props->background = json_next_color(json);
+    } else if (!layout_is_patching(layout)) {
+        // Clear rather than the SDK's white, but a patch leaves it alone.
+        props->set |= PROPERTY_BACKGROUND;
+        props->background = GColorClear;
+    }
+    if (json_seek(json, "alignment")) {
+        props->set |= PROPERTY_ALIGNMENT;
+        props->alignment = GTextAlignmentLeft;
+        switch (keyword_lookup(json_next_string_view(json))) {
+            case KEYWORD_CENTER: props->alignment = GTextAlignmentCenter; break;
+            case KEYWORD_RIGHT: props->alignment = GTextAlignmentRight; break;
+            default: break;
         }
-        free(key);
     }
+    if (json_seek(json, "font")) props->font = layout_get_font(layout, json_next_string_view(json));
 }
 
-static void prv_text_layer_destroy(void *object) {
-    TextLayer *layer = (TextLayer *) object;
-    char *buf = (char *) text_layer_get_text(layer);
-    if (buf) free(buf);
-    text_layer_destroy(layer);
+// Takes the text.
+static void prv_text_layer_set(Layout *layout, struct TextProperties *props, TextLayer *layer) {
+    if (props->set & PROPERTY_TEXT) {
+        char *text = props->text;
+        layout_unbind_text(layout, layer);
+        if (text && strstr(text, "{{")) {
+            text_layer_set_text(layer, layout_bind_text(layout, layer, text));
+            text = NULL;
+        } else {
+            text_layer_set_text(layer, text);
+        }
+        layout_own_text(layout, text);
+    }
+    if (props->set & PROPERTY_COLOR) text_layer_set_text_color(layer, props->color);
+    if (props->set & PROPERTY_BACKGROUND) text_layer_set_background_color(layer, props->background);
+    if (props->set & PROPERTY_ALIGNMENT) text_layer_set_text_alignment(layer, props->alignment);
+    if (props->font) text_layer_set_font(layer, props->font);
 }
 
 static void prv_text_layer_parse(Layout *layout, Json *json, void *object) {
-    TextLayer *layer = (TextLayer *) object;
-    text_layer_set_background_color(layer, GColorClear);
-
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "text")) {
-            char *text = json_next_string(json);
-            text_layer_set_text(layer, text);
-        } else if (eq(key, "color")) {
-            text_layer_set_text_color(layer, json_next_color(json));
-        } else if (eq(key, "background")) {
-            text_layer_set_background_color(layer, json_next_color(json));
-        } else if (eq(key, "alignment")) {
-            char *value = json_next_string(json);
-            GTextAlignment alignment = GTextAlignmentLeft;
-            if (eq(value, "GTextAlignmentCenter") || eq(value, "center")) alignment = GTextAlignmentCenter;
-            else if (eq(value, "GTextAlignmentRight") || eq(value, "right")) alignment = GTextAlignmentRight;
-            text_layer_set_text_alignment(layer, alignment);
-            free(value);
-        }  else if (eq(key, "font")) {
-            char *value = json_next_string(json);
-            GFont font = layout_get_font(layout, value);
-            if (font) text_layer_set_font(layer, font);
-            free(value);
-        } else {
-            json_skip_tree(json);
+    struct TextProperties props;
+    prv_text_layer_read(layout, json, &props);
+    prv_text_layer_set(layout, &props, (TextLayer *) object);
+}
+
+// The text is kept in the same block, after the properties.
+static void *prv_text_layer_compile(Layout *layout, Json *json) {
+    struct TextProperties props;
+    prv_text_layer_read(layout, json, &props);
+    size_t len = props.text ? strlen(props.text) + 1 : 0;
+    struct TextProperties *compiled = malloc(sizeof(struct TextProperties) + len);
+    *compiled = props;
+    if (props.text) {
+        compiled->text = (char *) (compiled + 1);
+        memcpy(compiled->text, props.text, len);
+        free(props.text);
+    }
+    return compiled;
+}
+
+// Every layout gets its own copy of the text, so the template can go first.
+static void prv_text_layer_instance(Layout *layout, const void *properties, void *object) {
+    struct TextProperties props = *(const struct TextProperties *) properties;
+    if (props.text) {
+        size_t len = strlen(props.text) + 1;
+        char *text = malloc(sizeof(char) * len);
+        memcpy(text, props.text, len);
+        props.text = text;
+    }
+    prv_text_layer_set(layout, &props, (TextLayer *) object);
+}
+
+struct BitmapProperties {
+    uint8_t set;
+    uint32_t *resource_id;
+    bool has_source;
+    GRect source;
+    GColor background;
+    GAlign alignment;
+    GCompOp compositing;
+};
+
+static void prv_bitmap_layer_read(Layout *layout, Json *json, struct BitmapProperties *props) {
+    props->set = 0;
+    props->resource_id = NULL;
+    props->has_source = json_seek(json, "source");
+    props->source = props->has_source ? layout_next_rect(json) : GRectZero;
+
+    if (json_seek(json, "bitmap")) props->resource_id = layout_get_resource(layout, json_next_string_view(json));
+    if (json_seek(json, "background")) {
+        props->set |= PROPERTY_BACKGROUND;
+        props->background = json_next_color(json);
+    } else if (!layout_is_patching(layout)) {
+        props->set |= PROPERTY_BACKGROUND;
+        props->background = GColorClear;
+    }
+    if (json_seek(json, "alignment")) {
+        props->set |= PROPERTY_ALIGNMENT;
+        props->alignment = GAlignCenter;
+        switch (keyword_lookup(json_next_string_view(json))) {
+            case KEYWORD_TOP_LEFT: props->alignment = GAlignTopLeft; break;
+            case KEYWORD_TOP: props->alignment = GAlignTop; break;
+            case KEYWORD_TOP_RIGHT: props->alignment = GAlignTopRight; break;
+            case KEYWORD_LEFT: props->alignment = GAlignLeft; break;
+            case KEYWORD_RIGHT: props->alignment = GAlignRight; break;
+            case KEYWORD_BOTTOM_LEFT: props->alignment = GAlignBottomLeft; break;
+            case KEYWORD_BOTTOM: props->alignment = GAlignBottom; break;
+            case KEYWORD_BOTTOM_RIGHT: props->alignment = GAlignBottomRight; break;
+            default: break;
+        }
+    }
+    if (json_seek(json, "compositing")) {
+        props->set |= PROPERTY_COMPOSITING;
+        props->compositing = GCompOpAssign;
+        switch (keyword_lookup(json_next_string_view(json))) {
+            case KEYWORD_INVERTED: props->compositing = GCompOpAssignInverted; break;
+            case KEYWORD_OR: props->compositing = GCompOpOr; break;
+            case KEYWORD_AND: props->compositing = GCompOpAnd; break;
+            case KEYWORD_CLEAR: props->compositing = GCompOpClear; break;
+            case KEYWORD_SET: props->compositing = GCompOpSet; break;
+            default: break;
         }
-        free(key);
     }
 }
 
-static void prv_bitmap_layer_parse(Layout *layout, Json *json, void *object) {
-    BitmapLayer *layer = (BitmapLayer *) object;
-    bitmap_layer_set_background_color(layer, GColorClear);
-
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "bitmap")) {
-            char *value = json_next_string(json);
-            uint32_t *resource_id = layout_get_resource(layout, value);
-            if (resource_id) {
-                GBitmap *bitmap = gbitmap_create_with_resource(*resource_id);
-                bitmap_layer_set_bitmap(layer, bitmap);
-            }
-            free(value);
-        } else if (eq(key, "background"))  {
-            GColor color = json_next_color(json);
-            bitmap_layer_set_background_color(layer, color);
-        }  else if (eq(key, "alignment")) {
-            char *value = json_next_string(json);
-            GAlign alignment = GAlignCenter;
-            if (eq(value, "top-left") || eq(value, "GAlignTopLeft")) alignment = GAlignTopLeft;
-            else if (eq(value, "top") || eq(value, "GAlignTop")) alignment = GAlignTop;
-            else if (eq(value, "top-right") || eq(value, "GAlignTopRight")) alignment = GAlignTopRight;
-            else if (eq(value, "left") || eq(value, "GAlignLeft")) alignment = GAlignLeft;
-            else if (eq(value, "right") || eq(value, "GAlignRight")) alignment = GAlignRight;
-            else if (eq(value, "bottom-left") || eq(value, "GAlignBottomLeft")) alignment = GAlignBottomLeft;
-            else if (eq(value, "bottom") || eq(value, "GAlignBottom")) alignment = GAlignBottom;
-            else if (eq(value, "bottom-right") || eq(value, "GAlignBottomRight")) alignment = GAlignBottomRight;
-            bitmap_layer_set_alignment(layer, alignment);
-            free(value);
-        }  else if (eq(key, "compositing")) {
-            char *value = json_next_string(json);
-            GCompOp compositing = GCompOpAssign;
-            if (eq(value, "inverted") || eq(value, "GCompOpAssignInverted")) compositing = GCompOpAssignInverted;
-            else if(eq(value, "or") || eq(value, "GCompOpOr")) compositing = GCompOpOr;
-            else if(eq(value, "and") || eq(value, "GCompOpAnd")) compositing = GCompOpAnd;
-            else if(eq(value, "clear") || eq(value, "GCompOpClear")) compositing = GCompOpClear;
-            else if(eq(value, "set") || eq(value, "GCompOpSet")) compositing = GCompOpSet;
-            bitmap_layer_set_compositing_mode(layer, compositing);
-            free(value);
-        } else {
-            json_skip_tree(json);
+static void prv_bitmap_layer_set(Layout *layout, const struct BitmapProperties *props, BitmapLayer *layer) {
+    if (props->resource_id) {
+        GBitmap *bitmap = props->has_source ? layout_get_sub_bitmap(layout, props->resource_id, props->source)
+                                            : layout_get_bitmap(layout, props->resource_id);
+        if (bitmap) {
+            layout_release_resource(layout, (GBitmap *) bitmap_layer_get_bitmap(layer));
+            bitmap_layer_set_bitmap(layer, bitmap);
         }
-        free(key);
     }
+    if (props->set & PROPERTY_BACKGROUND) bitmap_layer_set_background_color(layer, props->background);
+    if (props->set & PROPERTY_ALIGNMENT) bitmap_layer_set_alignment(layer, props->alignment);
+    if (props->set & PROPERTY_COMPOSITING) bitmap_layer_set_compositing_mode(layer, props->compositing);
 }
 
-static void prv_bitmap_layer_destroy(void *object) {
-    BitmapLayer *layer = (BitmapLayer *) object;
-    GBitmap *bitmap = (GBitmap *) bitmap_layer_get_bitmap(layer);
-    bitmap_layer_set_bitmap(layer, NULL);
-    if (bitmap) gbitmap_destroy(bitmap);
-    bitmap_layer_destroy(layer);
+static void prv_bitmap_layer_parse(Layout *layout, Json *json, void *object) {
+    struct BitmapProperties props;
+    prv_bitmap_layer_read(layout, json, &props);
+    prv_bitmap_layer_set(layout, &props, (BitmapLayer *) object);
 }
 
+static void *prv_bitmap_layer_compile(Layout *layout, Json *json) {
+    struct BitmapProperties *props = malloc(sizeof(struct BitmapProperties));
+    prv_bitmap_layer_read(layout, json, props);
+    return props;
+}
+
+struct StatusBarProperties {
+    uint8_t set;
+    GColor background;
+    GColor foreground;
+    StatusBarLayerSeparatorMode separator;
+};
+
 static void *prv_status_bar_layer_create(GRect frame) {
     StatusBarLayer *layer = status_bar_layer_create();
     if (!grect_equal(&frame, &GRectZero)) layer_set_frame(status_bar_layer_get_layer(layer), frame);
     return layer;
 }
 
-static void prv_status_bar_layer_parse(Layout *layout, Json *json, void *object) {
-    StatusBarLayer *layer = (StatusBarLayer *) object;
+static void prv_status_bar_layer_read(Layout *layout, Json *json, struct StatusBarProperties *props) {
+    props->set = 0;
+    if (json_seek(json, "background")) {
+        props->set |= PROPERTY_BACKGROUND;
+        props->background = json_next_color(json);
+    }
+    if (json_seek(json, "foreground")) {
+        props->set |= PROPERTY_FOREGROUND;
+        props->foreground = json_next_color(json);
+    }
+    if (json_seek(json, "separator")) {
+        props->set |= PROPERTY_SEPARATOR;
+        props->separator = StatusBarLayerSeparatorModeNone;
+        if (keyword_lookup(json_next_string_view(json)) == KEYWORD_DOTTED) {
+            props->separator = StatusBarLayerSeparatorModeDotted;
+        }
+    }
+}
 
+static void prv_status_bar_layer_set(Layout *layout, const struct StatusBarProperties *props, StatusBarLayer *layer) {
     GColor background = status_bar_layer_get_background_color(layer);
     GColor foreground = status_bar_layer_get_foreground_color(layer);
 
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "background")) {
-            background = json_next_color(json);
-        } else if (eq(key, "foreground")) {
-            foreground = json_next_color(json);
-        }  else if (eq(key, "separator")) {
-            char *value = json_next_string(json);
-            StatusBarLayerSeparatorMode mode = StatusBarLayerSeparatorModeNone;
-            if (eq(value, "dotted") || eq(value, "StatusBarLayerSeparatorModeDotted")) {
-                mode = StatusBarLayerSeparatorModeDotted;
-            }
-            status_bar_layer_set_separator_mode(layer, mode);
-            free(value);
-        } else {
-            json_skip_tree(json);
-        }
-        free(key);
-    }
+    if (props->set & PROPERTY_BACKGROUND) background = props->background;
+    if (props->set & PROPERTY_FOREGROUND) foreground = props->foreground;
+    if (props->set & PROPERTY_SEPARATOR) status_bar_layer_set_separator_mode(layer, props->separator);
 
     status_bar_layer_set_colors(layer, background, foreground);
 }
 
+static void prv_status_bar_layer_parse(Layout *layout, Json *json, void *object) {
+    struct StatusBarProperties props;
+    prv_status_bar_layer_read(layout, json, &props);
+    prv_status_bar_layer_set(layout, &props, (StatusBarLayer *) object);
+}
+
+static void *prv_status_bar_layer_compile(Layout *layout, Json *json) {
+    struct StatusBarProperties *props = malloc(sizeof(struct StatusBarProperties));
+    prv_status_bar_layer_read(layout, json, props);
+    return props;
+}
+
 struct PdcLayerData {
     GDrawCommandImage *pdc;
     GPoint offset;
 };
 
+struct PdcProperties {
+    uint8_t set;
+    uint32_t *resource_id;
+    GPoint offset;
+};
+
 static void prv_pdc_layer_update_proc(Layer *layer, GContext *ctx) {
     struct PdcLayerData *data = layer_get_data(layer);
     if (data->pdc) gdraw_command_image_draw(ctx, data->pdc, data->offset);
@@ -193,93 +327,236 @@ static void *prv_pdc_layer_create(GRect frame) {
     return layer;
 }
 
-static void prv_pdc_layer_destroy(void *object) {
-    Layer *layer = (Layer *) object;
-    struct PdcLayerData *data = layer_get_data(layer);
+static void prv_pdc_layer_read(Layout *layout, Json *json, struct PdcProperties *props) {
+    props->set = 0;
+    props->resource_id = NULL;
+
+    if (json_seek(json, "pdc")) props->resource_id = layout_get_resource(layout, json_next_string_view(json));
+    if (json_seek(json, "offset")) {
+        json_advance(json);
+        int x = 0, y = 0;
+        if (json_is_array(json)) {
+            x = json_next_int(json);
+            y = json_next_int(json);
+        } else if (json_is_object(json)) {
+            size_t len = json_get_size(json);
+            for (size_t j = 0; j < len; j++) {
+                JsonString key = json_next_string_view(json);
+                char c = key.len > 0 ? key.str[0] : '\0';
+                if (c == 'x') x = json_next_int(json);
+                else if (c == 'y') y = json_next_int(json);
+                else json_skip_tree(json);
+            }
+        }
+        props->set |= PROPERTY_OFFSET;
+        props->offset = GPoint(x, y);
+    }
+}
 
-    if (data->pdc) gdraw_command_image_destroy(data->pdc);
-    data->pdc = NULL;
+static void prv_pdc_layer_set(Layout *layout, const struct PdcProperties *props, Layer *layer) {
+    struct PdcLayerData *data = layer_get_data(layer);
 
-    layer_destroy(layer);
+    if (props->resource_id) {
+        GDrawCommandImage *pdc = layout_get_pdc(layout, props->resource_id);
+        if (pdc) {
+            layout_release_resource(layout, data->pdc);
+            data->pdc = pdc;
+        }
+    }
+    if (props->set & PROPERTY_OFFSET) data->offset = props->offset;
 }
 
 static void prv_pdc_layer_parse(Layout *layout, Json *json, void *object) {
-    Layer *layer = (Layer *) object;
-    struct PdcLayerData *data = layer_get_data(layer);
+    struct PdcProperties props;
+    prv_pdc_layer_read(layout, json, &props);
+    prv_pdc_layer_set(layout, &props, (Layer *) object);
+}
 
-    size_t size = json_get_size(json);
-    for (size_t i = 0; i < size; i++) {
-        char *key = json_next_string(json);
-        if (eq(key, "pdc")) {
-            char *value = json_next_string(json);
-            uint32_t *resource_id = layout_get_resource(layout, value);
-            if (resource_id) {
-                data->pdc = gdraw_command_image_create_with_resource(*resource_id);
-            }
-            free(value);
-        } else if (eq(key, "offset")) {
-            json_advance(json);
-            int x = 0, y = 0;
-            if (json_is_array(json)) {
-                x = json_next_int(json);
-                y = json_next_int(json);
-            } else if (json_is_object(json)) {
-                size_t len = json_get_size(json);
-                for (size_t j = 0; j < len; j++) {
-                    char *value = json_next_string(json);
-                    if (value[0] == 'x') x = json_next_int(json);
-                    else if (value[0] == 'y') y = json_next_int(json);
-                    else json_skip_tree(json);
-                    free(value);
-                }
-            }
-            data->offset = GPoint(x, y);
-        } else {
-            json_skip_tree(json);
+static void *prv_pdc_layer_compile(Layout *layout, Json *json) {
+    struct PdcProperties *props = malloc(sizeof(struct PdcProperties));
+    prv_pdc_layer_read(layout, json, props);
+    return props;
+}
+
+// Only enough rows to fill the frame are built from the row template. When
+// the list scrolls, rows that leave the frame are moved and bound to the
+// items coming into view.
+struct RepeatLayer {
+    Layer *layer;
+    LayoutTemplate *row;
+    int16_t row_height;
+    Layout **rows;
+    int32_t *items;
+    uint16_t num_rows;
+    uint16_t count;
+    int16_t offset;
+    RepeatLayerBindCallback bind;
+    void *context;
+};
+
+static void *prv_repeat_layer_create(GRect frame) {
+    RepeatLayer *repeat_layer = malloc(sizeof(RepeatLayer));
+    repeat_layer->layer = layer_create(frame);
+    layer_set_clips(repeat_layer->layer, true);
+    repeat_layer->row = NULL;
+    repeat_layer->row_height = 0;
+    repeat_layer->rows = NULL;
+    repeat_layer->items = NULL;
+    repeat_layer->num_rows = 0;
+    repeat_layer->count = 0;
+    repeat_layer->offset = 0;
+    repeat_layer->bind = NULL;
+    repeat_layer->context = NULL;
+    return repeat_layer;
+}
+
+static void prv_repeat_layer_destroy(void *object) {
+    RepeatLayer *repeat_layer = (RepeatLayer *) object;
+    for (uint16_t i = 0; i < repeat_layer->num_rows; i++) {
+        layout_destroy(repeat_layer->rows[i]);
+    }
+    free(repeat_layer->rows);
+    free(repeat_layer->items);
+    if (repeat_layer->row) layout_template_destroy(repeat_layer->row);
+    layer_destroy(repeat_layer->layer);
+    free(repeat_layer);
+}
+
+static void prv_repeat_layer_parse(Layout *layout, Json *json, void *object) {
+    RepeatLayer *repeat_layer = (RepeatLayer *) object;
+    if (repeat_layer->row || !json_seek(json, "layers")) return;
+
+    json_advance(json);
+    if (!json_is_array(json) || json_get_size(json) == 0) return;
+    json_advance(json);
+
+    LayoutTemplate *row = layout_template_create_from_tree(layout, json);
+    if (!row) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "RepeatLayer row could not be read");
+        return;
+    }
+    GRect frame = layout_template_get_frame(row);
+    if (frame.size.h <= 0) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "RepeatLayer needs a row with a height");
+        layout_template_destroy(row);
+        return;
+    }
+    repeat_layer->row = row;
+    repeat_layer->row_height = frame.size.h;
+}
+
+static Layer *prv_repeat_layer_get_layer(void *object) {
+    return ((RepeatLayer *) object)->layer;
+}
+
+static void prv_repeat_layer_update(RepeatLayer *repeat_layer) {
+    if (!repeat_layer->row) return;
+
+    int16_t height = layer_get_bounds(repeat_layer->layer).size.h;
+    uint16_t needed = height / repeat_layer->row_height + 2;
+    if (needed > repeat_layer->count) needed = repeat_layer->count;
+    if (needed > repeat_layer->num_rows) {
+        repeat_layer->rows = realloc(repeat_layer->rows, sizeof(Layout *) * needed);
+        repeat_layer->items = realloc(repeat_layer->items, sizeof(int32_t) * needed);
+        for (uint16_t i = repeat_layer->num_rows; i < needed; i++) {
+            repeat_layer->rows[i] = layout_create_from_template(repeat_layer->row, NULL);
+            repeat_layer->items[i] = -1;
+            layer_add_child(repeat_layer->layer, layout_get_layer(repeat_layer->rows[i]));
         }
-        free(key);
+        // Every row changes place when there are more of them.
+        for (uint16_t i = 0; i < repeat_layer->num_rows; i++) repeat_layer->items[i] = -1;
+        repeat_layer->num_rows = needed;
     }
+
+    uint16_t n = repeat_layer->num_rows;
+    if (n == 0) return;
+    int32_t first = repeat_layer->offset > 0 ? repeat_layer->offset / repeat_layer->row_height : 0;
+    for (uint16_t i = 0; i < n; i++) {
+        // Item k always uses row k % n, so only rows that scroll into view
+        // are bound again.
+        int32_t item = first + (i - first % n + n) % n;
+        Layer *layer = layout_get_layer(repeat_layer->rows[i]);
+        if (item >= repeat_layer->count) {
+            layer_set_hidden(layer, true);
+            continue;
+        }
+
+        if (repeat_layer->items[i] != item) {
+            repeat_layer->items[i] = item;
+            if (repeat_layer->bind) repeat_layer->bind(repeat_layer->rows[i], item, repeat_layer->context);
+        }
+        GRect frame = layer_get_frame(layer);
+        frame.origin.y = item * repeat_layer->row_height - repeat_layer->offset;
+        layer_set_frame(layer, frame);
+        layer_set_hidden(layer, false);
+    }
+}
+
+Layer *repeat_layer_get_layer(RepeatLayer *repeat_layer) {
+    return repeat_layer->layer;
+}
+
+void repeat_layer_set_data(RepeatLayer *repeat_layer, uint16_t count, RepeatLayerBindCallback bind, void *context) {
+    repeat_layer->count = count;
+    repeat_layer->bind = bind;
+    repeat_layer->context = context;
+    for (uint16_t i = 0; i < repeat_layer->num_rows; i++) repeat_layer->items[i] = -1;
+    prv_repeat_layer_update(repeat_layer);
+}
+
+void repeat_layer_set_offset(RepeatLayer *repeat_layer, int16_t offset) {
+    repeat_layer->offset = offset;
+    prv_repeat_layer_update(repeat_layer);
 }
 
 void standard_types_add_default_type(Layout *layout) {
-    layout_add_type(layout, "Layer", (TypeFuncs) {
+    layout_add_compiled_type(layout, "Layer", (TypeFuncs) {
         .create = prv_default_layer_create,
         .destroy = (TypeDestroyFunc) layer_destroy,
         .parse = prv_default_layer_parse
-    }, NULL);
+    }, prv_default_layer_compile, (TypeInstanceFunc) prv_default_layer_set);
 }
 
 void standard_types_add_text_type(Layout *layout) {
-    layout_add_type(layout, "TextLayer", (TypeFuncs) {
+    layout_add_compiled_type(layout, "TextLayer", (TypeFuncs) {
         .create = (TypeCreateFunc) text_layer_create,
-        .destroy = prv_text_layer_destroy,
+        .destroy = (TypeDestroyFunc) text_layer_destroy,
         .parse = prv_text_layer_parse,
         .get_layer = (TypeGetLayerFunc) text_layer_get_layer
-    }, NULL);
+    }, prv_text_layer_compile, prv_text_layer_instance);
 }
 
 void standard_types_add_bitmap_type(Layout *layout) {
-    layout_add_type(layout, "BitmapLayer", (TypeFuncs) {
+    layout_add_compiled_type(layout, "BitmapLayer", (TypeFuncs) {
         .create = (TypeCreateFunc) bitmap_layer_create,
-        .destroy = prv_bitmap_layer_destroy,
+        .destroy = (TypeDestroyFunc) bitmap_layer_destroy,
         .parse = prv_bitmap_layer_parse,
         .get_layer = (TypeGetLayerFunc) bitmap_layer_get_layer
-    }, NULL);
+    }, prv_bitmap_layer_compile, (TypeInstanceFunc) prv_bitmap_layer_set);
 }
 
 void standard_types_add_status_bar_type(Layout *layout) {
-    layout_add_type(layout, "StatusBarLayer", (TypeFuncs) {
+    layout_add_compiled_type(layout, "StatusBarLayer", (TypeFuncs) {
         .create = prv_status_bar_layer_create,
         .destroy = (TypeDestroyFunc) status_bar_layer_destroy,
         .parse = prv_status_bar_layer_parse,
         .get_layer = (TypeGetLayerFunc) status_bar_layer_get_layer
-    }, NULL);
+    }, prv_status_bar_layer_compile, (TypeInstanceFunc) prv_status_bar_layer_set);
 }
 
 void standard_types_add_pdc_type(Layout *layout) {
-    layout_add_type(layout, "PdcLayer", (TypeFuncs) {
+    layout_add_compiled_type(layout, "PdcLayer", (TypeFuncs) {
         .create = prv_pdc_layer_create,
-        .destroy = prv_pdc_layer_destroy,
+        .destroy = (TypeDestroyFunc) layer_destroy,
         .parse = prv_pdc_layer_parse
-    }, NULL);
+    }, prv_pdc_layer_compile, (TypeInstanceFunc) prv_pdc_layer_set);
+}
+
+void standard_types_add_repeat_type(Layout *layout) {
+    layout_add_container_type(layout, "RepeatLayer", (TypeFuncs) {
+        .create = prv_repeat_layer_create,
+        .destroy = prv_repeat_layer_destroy,
+        .parse = prv_repeat_layer_parse,
+        .get_layer = prv_repeat_layer_get_layer
+    });
 }
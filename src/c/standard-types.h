@@ -1,7 +1,14 @@
 #include <pebble-layout.h>
 
+#define STANDARD_TYPE_COUNT 6
+
+// Compiled layouts refer to the standard types by their index here, so the
+// order is shared with tools/compile_layout.py.
+extern const char *const STANDARD_TYPE_NAMES[STANDARD_TYPE_COUNT];
+
 void standard_types_add_default_type(Layout *layout);
 void standard_types_add_text_type(Layout *layout);
 void standard_types_add_bitmap_type(Layout *layout);
 void standard_types_add_status_bar_type(Layout *layout);
 void standard_types_add_pdc_type(Layout *layout);
+void standard_types_add_repeat_type(Layout *layout);
@@ -0,0 +1,330 @@
+#!/usr/bin/env python
+#
+# Compiles a pebble-layout JSON file into the binary format read by
+# layout_parse_binary_resource().
+#
+# The output is the token stream the device would otherwise get from jsmn,
+# so no tokenizing happens at load time:
+#
+#   char     magic[4]      "PLB2"
+#   uint16   num_tokens
+#   uint16   pool_size
+#   token    tokens[num_tokens]
+#   char     pool[pool_size]
+#
+# Each token is { uint8 type, uint8 value, uint16 size, uint16 start,
+# uint16 len }, where start/len locate the token's text in the string pool.
+# The text is the raw source, escapes included, just as jsmn gives it. Keys,
+# strings and primitives are interned, so repeated property names and values
+# are stored once. All integers are little-endian.
+#
+# Some values of the standard types are stored already read, flagged in the
+# high bits of type:
+#
+#   COLOR   a "#RRGGBB" string, with its GColor in value
+#   TYPE    a "type" naming a standard type, with its index in value
+#   FRAME   a "frame" of integers, with a pool record { int16 x, y, w, h }
+#           at start; its children still follow it
+#
+# Flagged strings keep their text, so anything reading them as strings sees
+# no difference.
+#
+# With --platform the layout is specialized for one watch: layers whose
+# "capabilities" don't hold there are dropped, and the check is removed from
+# the rest, so the watch never sees either. Give --platform several times to
+# write one resource per platform, named with the SDK's ~platform tag.
+#
+from __future__ import print_function
+
+import argparse
+import io
+import json
+import os
+import re
+import struct
+import sys
+
+MAGIC = b'PLB2'
+
+TOKEN_OBJECT = 1
+TOKEN_ARRAY = 2
+TOKEN_STRING = 3
+TOKEN_PRIMITIVE = 4
+
+FLAG_COLOR = 0x10
+FLAG_TYPE = 0x20
+FLAG_FRAME = 0x40
+
+# STANDARD_TYPE_NAMES in src/c/standard-types.c, in the same order.
+STANDARD_TYPES = ['Layer', 'TextLayer', 'BitmapLayer', 'StatusBarLayer', 'PdcLayer', 'RepeatLayer']
+
+COLOR = re.compile(r'^#?[0-9a-fA-F]{6}$')
+INTEGER = re.compile(r'^-?[0-9]+$')
+
+MAX_TOKENS = 0x7FFF
+MAX_POOL = 0xFFFF
+
+# What prv_eval_capabilities() sees on each platform.
+PLATFORM_CAPABILITIES = {
+    'aplite': {'PLATFORM_APLITE', 'BW', 'RECT'},
+    'basalt': {'PLATFORM_BASALT', 'COLOR', 'RECT', 'HEALTH', 'MICROPHONE', 'SMARTSTRAP'},
+    'chalk': {'PLATFORM_CHALK', 'COLOR', 'ROUND', 'HEALTH', 'MICROPHONE', 'SMARTSTRAP'},
+    'diorite': {'PLATFORM_DIORITE', 'BW', 'RECT', 'HEALTH', 'MICROPHONE', 'SMARTSTRAP'},
+    'emery': {'COLOR', 'RECT', 'HEALTH', 'MICROPHONE', 'SMARTSTRAP'},
+}
+
+
+class Pairs(list):
+    """Keeps object keys in document order, duplicates included."""
+
+
+class String(type(u'')):
+    """The raw text between a string's quotes, escapes included."""
+
+
+class Primitive(type(u'')):
+    """The text of a number, true, false or null."""
+
+
+class RawParser(object):
+    """Reads JSON keeping every string and primitive as its source text, the
+    way jsmn does on the watch. The text is checked with json.loads first."""
+
+    def __init__(self, text):
+        self.text = text
+        self.pos = 0
+
+    def skip(self):
+        while self.pos < len(self.text) and self.text[self.pos] in ' \t\r\n':
+            self.pos += 1
+
+    def value(self):
+        self.skip()
+        c = self.text[self.pos]
+        if c == '{':
+            self.pos += 1
+            out = Pairs()
+            self.skip()
+            while self.text[self.pos] != '}':
+                key = self.value()
+                self.skip()
+                self.pos += 1  # ':'
+                out.append((key, self.value()))
+                self.skip()
+                if self.text[self.pos] == ',':
+                    self.pos += 1
+                    self.skip()
+            self.pos += 1
+            return out
+        if c == '[':
+            self.pos += 1
+            out = []
+            self.skip()
+            while self.text[self.pos] != ']':
+                out.append(self.value())
+                self.skip()
+                if self.text[self.pos] == ',':
+                    self.pos += 1
+                    self.skip()
+            self.pos += 1
+            return out
+        if c == '"':
+            start = self.pos + 1
+            self.pos = start
+            while self.text[self.pos] != '"':
+                self.pos += 2 if self.text[self.pos] == '\\' else 1
+            self.pos += 1
+            return String(self.text[start:self.pos - 1])
+        start = self.pos
+        while self.pos < len(self.text) and self.text[self.pos] not in ',]} \t\r\n':
+            self.pos += 1
+        return Primitive(self.text[start:self.pos])
+
+
+def color_value(text):
+    """The GColor argb byte GColorFromHEX() makes of a color."""
+    rgb = int(text.lstrip('#'), 16)
+    return 0xC0 | (rgb >> 22 & 3) << 4 | (rgb >> 14 & 3) << 2 | (rgb >> 6 & 3)
+
+
+def int16(value):
+    return isinstance(value, Primitive) and INTEGER.match(value) and -0x8000 <= int(value) <= 0x7FFF
+
+
+def frame_record(value):
+    """The frame layout_next_rect() reads from value, or None if it doesn't
+    hold only integers that fit."""
+    rect = {'x': 0, 'y': 0, 'w': 0, 'h': 0}
+    if isinstance(value, Pairs):
+        for key, child in value:
+            if key[:1] not in rect:
+                continue
+            if not int16(child):
+                return None
+            rect[key[:1]] = int(child)
+    elif isinstance(value, list) and len(value) == 4:
+        if not all(int16(child) for child in value):
+            return None
+        rect = dict(zip('xywh', (int(child) for child in value)))
+    else:
+        return None
+    return struct.pack('<hhhh', rect['x'], rect['y'], rect['w'], rect['h'])
+
+
+class LayoutCompiler(object):
+    def __init__(self):
+        self.tokens = []
+        self.pool = bytearray()
+        self.interned = {}
+
+    def intern(self, data):
+        if data not in self.interned:
+            self.interned[data] = len(self.pool)
+            self.pool.extend(data)
+        return self.interned[data], len(data)
+
+    def token(self, type, size, data=b'', value=0):
+        start, length = self.intern(data)
+        self.tokens.append((type, value, size, start, length))
+
+    def value(self, value, key=None):
+        if isinstance(value, (Pairs, list)):
+            type = TOKEN_OBJECT if isinstance(value, Pairs) else TOKEN_ARRAY
+            record = frame_record(value) if key == 'frame' else None
+            if record is None:
+                self.token(type, len(value))
+            else:
+                self.token(type | FLAG_FRAME, len(value), record)
+            if type == TOKEN_OBJECT:
+                for child_key, child in value:
+                    self.token(TOKEN_STRING, 1, child_key.encode('utf-8'))
+                    self.value(child, child_key)
+            else:
+                for child in value:
+                    self.value(child)
+        elif isinstance(value, String):
+            data = value.encode('utf-8')
+            if key == 'type' and value in STANDARD_TYPES:
+                self.token(TOKEN_STRING | FLAG_TYPE, 0, data, STANDARD_TYPES.index(value))
+            elif COLOR.match(value):
+                self.token(TOKEN_STRING | FLAG_COLOR, 0, data, color_value(value))
+            else:
+                self.token(TOKEN_STRING, 0, data)
+        else:
+            self.token(TOKEN_PRIMITIVE, 0, value.encode('utf-8'))
+
+    def compile(self, layout):
+        self.value(layout)
+        if len(self.tokens) > MAX_TOKENS:
+            raise ValueError('layout has {} tokens, the limit is {}'.format(len(self.tokens), MAX_TOKENS))
+        if len(self.pool) > MAX_POOL:
+            raise ValueError('string pool is {} bytes, the limit is {}'.format(len(self.pool), MAX_POOL))
+
+        out = bytearray(MAGIC)
+        out.extend(struct.pack('<HH', len(self.tokens), len(self.pool)))
+        for token in self.tokens:
+            out.extend(struct.pack('<BBHHH', *token))
+        out.extend(self.pool)
+        return bytes(out)
+
+
+def has_capabilities(node, platform):
+    capabilities = PLATFORM_CAPABILITIES[platform]
+    for key, value in node:
+        if key != 'capabilities' or not isinstance(value, list):
+            continue
+        for name in value:
+            if not isinstance(name, String):
+                return False
+            negated = name.startswith('NOT_') and len(name) > 4
+            if negated:
+                name = name[4:]
+            if (name in capabilities) == negated:
+                return False
+    return True
+
+
+def specialize(node, platform):
+    """Returns the layer with everything that can't show on platform removed,
+    or None if the layer itself can't."""
+    if not isinstance(node, Pairs):
+        return node
+    if not has_capabilities(node, platform):
+        return None
+
+    out = Pairs()
+    for key, value in node:
+        if key == 'capabilities':
+            continue
+        if key == 'layers' and isinstance(value, list):
+            value = [child for child in (specialize(c, platform) for c in value) if child is not None]
+        out.append((key, value))
+    return out
+
+
+def platform_path(path, platform):
+    root, ext = os.path.splitext(path)
+    return '{}~{}{}'.format(root, platform, ext)
+
+
+def load(path):
+    with io.open(path, encoding='utf-8') as f:
+        text = f.read()
+    json.loads(text)
+    return RawParser(text).value()
+
+
+def compile_layout(layout):
+    return LayoutCompiler().compile(layout)
+
+
+def layout_to_json(value):
+    """Writes the layout back out with every string as it was in the source."""
+    if isinstance(value, Pairs):
+        return u'{' + u','.join(u'"{}":{}'.format(key, layout_to_json(child)) for key, child in value) + u'}'
+    if isinstance(value, list):
+        return u'[' + u','.join(layout_to_json(child) for child in value) + u']'
+    if isinstance(value, String):
+        return u'"' + value + u'"'
+    return value
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Compile a pebble-layout JSON file into its binary form.')
+    parser.add_argument('input', help='layout JSON file')
+    parser.add_argument('output', help='binary resource to write')
+    parser.add_argument('--platform', action='append', choices=sorted(PLATFORM_CAPABILITIES),
+                        help='specialize the layout for a platform; repeat for one output per platform')
+    parser.add_argument('--json', action='store_true',
+                        help='write JSON for layout_parse_resource() instead of the binary form')
+    args = parser.parse_args(argv)
+
+    layout = load(args.input)
+    outputs = [(args.output, layout)]
+    if args.platform:
+        outputs = []
+        for platform in args.platform:
+            path = args.output if len(args.platform) == 1 else platform_path(args.output, platform)
+            specialized = specialize(layout, platform)
+            if specialized is None:
+                print('{}: the root layer is excluded on {}'.format(args.input, platform), file=sys.stderr)
+                return 1
+            outputs.append((path, specialized))
+
+    for path, layout in outputs:
+        try:
+            if args.json:
+                blob = layout_to_json(layout).encode('utf-8')
+            else:
+                blob = compile_layout(layout)
+        except ValueError as e:
+            print('{}: {}'.format(args.input, e), file=sys.stderr)
+            return 1
+
+        with open(path, 'wb') as f:
+            f.write(blob)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
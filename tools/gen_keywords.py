@@ -0,0 +1,201 @@
+#!/usr/bin/env python
+#
+# Generates src/c/keywords.h and src/c/keywords.c: a perfect hash over every
+# enum value and capability name the standard types understand, so looking
+# one up is a single probe and a single compare.
+#
+# Each keyword lists the spellings that map to it. Rerun this after changing
+# the list:
+#
+#   python tools/gen_keywords.py
+#
+from __future__ import print_function
+
+import os
+import sys
+
+KEYWORDS = [
+    # GTextAlignment and GAlign
+    ('LEFT', ['left', 'GTextAlignmentLeft', 'GAlignLeft']),
+    ('CENTER', ['center', 'GTextAlignmentCenter', 'GAlignCenter']),
+    ('RIGHT', ['right', 'GTextAlignmentRight', 'GAlignRight']),
+    ('TOP_LEFT', ['top-left', 'GAlignTopLeft']),
+    ('TOP', ['top', 'GAlignTop']),
+    ('TOP_RIGHT', ['top-right', 'GAlignTopRight']),
+    ('BOTTOM_LEFT', ['bottom-left', 'GAlignBottomLeft']),
+    ('BOTTOM', ['bottom', 'GAlignBottom']),
+    ('BOTTOM_RIGHT', ['bottom-right', 'GAlignBottomRight']),
+    # GCompOp
+    ('ASSIGN', ['assign', 'GCompOpAssign']),
+    ('INVERTED', ['inverted', 'GCompOpAssignInverted']),
+    ('OR', ['or', 'GCompOpOr']),
+    ('AND', ['and', 'GCompOpAnd']),
+    ('CLEAR', ['clear', 'GCompOpClear']),
+    ('SET', ['set', 'GCompOpSet']),
+    # StatusBarLayerSeparatorMode
+    ('NONE', ['none', 'StatusBarLayerSeparatorModeNone']),
+    ('DOTTED', ['dotted', 'StatusBarLayerSeparatorModeDotted']),
+    # Capabilities
+    ('PLATFORM_APLITE', ['PLATFORM_APLITE']),
+    ('PLATFORM_BASALT', ['PLATFORM_BASALT']),
+    ('PLATFORM_CHALK', ['PLATFORM_CHALK']),
+    ('PLATFORM_DIORITE', ['PLATFORM_DIORITE']),
+    ('BW', ['BW']),
+    ('COLOR', ['COLOR']),
+    ('HEALTH', ['HEALTH']),
+    ('RECT', ['RECT']),
+    ('ROUND', ['ROUND']),
+    ('MICROPHONE', ['MICROPHONE']),
+    ('SMARTSTRAP', ['SMARTSTRAP']),
+]
+
+
+def fnv1a(s):
+    h = 2166136261
+    for c in bytearray(s.encode('ascii')):
+        h ^= c
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def mix(h):
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def find_hash(words):
+    """Hash and displace: words are grouped into buckets by hash, then each
+    bucket, largest first, gets the displacement that moves all of its words
+    into free slots."""
+    size = 1
+    while size < len(words):
+        size *= 2
+    while True:
+        num_buckets = max(1, size // 4)
+        buckets = [[] for _ in range(num_buckets)]
+        for w in words:
+            buckets[fnv1a(w) & (num_buckets - 1)].append(w)
+
+        displace = [0] * num_buckets
+        taken = set()
+        for b in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+            for d in range(256):
+                slots = set(mix(fnv1a(w) ^ d) & (size - 1) for w in buckets[b])
+                if len(slots) == len(buckets[b]) and not slots & taken:
+                    displace[b] = d
+                    taken |= slots
+                    break
+            else:
+                break
+        else:
+            return displace, size
+        size *= 2
+
+
+def generate():
+    words = {}
+    for name, spellings in KEYWORDS:
+        for s in spellings:
+            if s in words:
+                raise ValueError('{} is listed twice'.format(s))
+            if len(s) > 0xFF:
+                raise ValueError('{} is too long'.format(s))
+            words[s] = name
+
+    displace, size = find_hash(sorted(words))
+    table = [None] * size
+    for s, name in words.items():
+        table[mix(fnv1a(s) ^ displace[fnv1a(s) & (len(displace) - 1)]) & (size - 1)] = (s, name)
+
+    # Strings live in one pool so a table entry is four bytes.
+    pool = []
+    offsets = {}
+    offset = 0
+    for entry in table:
+        if entry:
+            offsets[entry[0]] = offset
+            pool.append(entry[0])
+            offset += len(entry[0])
+    if offset > 0xFFFF:
+        raise ValueError('keyword pool is too large')
+
+    header = ['// Generated by tools/gen_keywords.py. Do not edit.',
+              '#pragma once',
+              '#include <pebble-json.h>',
+              '',
+              'typedef enum {',
+              '    KEYWORD_UNKNOWN = 0,']
+    header += ['    KEYWORD_{},'.format(name) for name, _ in KEYWORDS]
+    header += ['} Keyword;',
+               '',
+               'Keyword keyword_lookup(JsonString s);',
+               '']
+
+    source = ['// Generated by tools/gen_keywords.py. Do not edit.',
+              '#include <pebble.h>',
+              '#include "keywords.h"',
+              '',
+              '#define KEYWORD_TABLE_SIZE {}'.format(size),
+              '#define KEYWORD_NUM_BUCKETS {}'.format(len(displace)),
+              '',
+              'static const char s_pool[] =']
+    source += ['    "{}"'.format(s) for s in pool]
+    source[-1] += ';'
+    source += ['',
+               'static const uint8_t s_displace[KEYWORD_NUM_BUCKETS] = {',
+               '    ' + ', '.join(str(d) for d in displace),
+               '};',
+               '',
+               'static const struct {',
+               '    uint16_t offset;',
+               '    uint8_t len;',
+               '    uint8_t keyword;',
+               '} s_keywords[KEYWORD_TABLE_SIZE] = {']
+    for entry in table:
+        if entry:
+            source.append('    {{ {}, {}, KEYWORD_{} }},'.format(offsets[entry[0]], len(entry[0]), entry[1]))
+        else:
+            source.append('    { 0, 0, KEYWORD_UNKNOWN },')
+    source += ['};',
+               '',
+               'Keyword keyword_lookup(JsonString s) {',
+               '    if (s.str == NULL) return KEYWORD_UNKNOWN;',
+               '    uint32_t hash = 2166136261u;',
+               '    for (size_t i = 0; i < s.len; i++) {',
+               '        hash ^= (uint8_t) s.str[i];',
+               '        hash *= 16777619u;',
+               '    }',
+               '',
+               '    uint32_t h = hash ^ s_displace[hash & (KEYWORD_NUM_BUCKETS - 1)];',
+               '    h ^= h >> 16;',
+               '    h *= 0x85EBCA6Bu;',
+               '    h ^= h >> 13;',
+               '    h *= 0xC2B2AE35u;',
+               '    h ^= h >> 16;',
+               '',
+               '    uint16_t i = h & (KEYWORD_TABLE_SIZE - 1);',
+               '    if (s_keywords[i].len != s.len || strncmp(s_pool + s_keywords[i].offset, s.str, s.len) != 0) {',
+               '        return KEYWORD_UNKNOWN;',
+               '    }',
+               '    return s_keywords[i].keyword;',
+               '}',
+               '']
+    return '\n'.join(header), '\n'.join(source)
+
+
+def main(argv):
+    out = argv[0] if argv else os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'src', 'c')
+    header, source = generate()
+    with open(os.path.join(out, 'keywords.h'), 'w') as f:
+        f.write(header)
+    with open(os.path.join(out, 'keywords.c'), 'w') as f:
+        f.write(source)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,115 @@
+#!/usr/bin/env python
+#
+# Generates synthetic layouts for benchmarking pebble-layout: a tree with the
+# requested number of layers and depth, made of the standard types with the
+# properties a real watchface would set.
+#
+#   python tools/gen_layout.py --nodes 500 --depth 6 resources/bench.json
+#
+# --suite writes one file per size and depth instead, named
+# bench-<nodes>-<depth>.json, to compare how parsing scales:
+#
+#   python tools/gen_layout.py --suite resources/bench
+#
+# Output is deterministic for a given --seed. BitmapLayers name the resource
+# given by --bitmap, which the app has to add with layout_add_resource().
+#
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import random
+import sys
+
+SUITE_NODES = [10, 50, 100, 500, 1000, 2000]
+SUITE_DEPTHS = [2, 4, 8]
+
+ALIGNMENTS = ['left', 'center', 'right']
+COLORS = ['#000000', '#FFFFFF', '#FF0000', '#00FF00', '#0000FF', '#FFAA00']
+FONTS = ['GOTHIC_14', 'GOTHIC_18_BOLD', 'GOTHIC_24', 'BITHAM_42_LIGHT']
+
+
+def make_layer(rng, i, bitmap):
+    layer = {'id': 'l{}'.format(i), 'frame': [rng.randint(0, 100), rng.randint(0, 100), rng.randint(10, 144), rng.randint(10, 168)]}
+    r = rng.random()
+    if r < 0.4:
+        layer['type'] = 'TextLayer'
+        layer['text'] = ' '.join('word{}'.format(rng.randint(0, 999)) for _ in range(rng.randint(1, 8)))
+        layer['font'] = rng.choice(FONTS)
+        layer['color'] = rng.choice(COLORS)
+        layer['alignment'] = rng.choice(ALIGNMENTS)
+    elif r < 0.5 and bitmap:
+        layer['type'] = 'BitmapLayer'
+        layer['bitmap'] = bitmap
+        layer['alignment'] = 'center'
+    if rng.random() < 0.1:
+        layer['capabilities'] = [rng.choice(['COLOR', 'BW', 'ROUND', 'RECT'])]
+    if rng.random() < 0.05:
+        layer['hidden'] = True
+    return layer
+
+
+def generate(nodes, depth, seed, bitmap):
+    rng = random.Random(seed)
+    root = {'id': 'root', 'layers': []}
+    count = 1
+
+    # A chain down to the requested depth, then the rest hung off random
+    # layers that aren't already at the bottom.
+    parents = [(root, 0)]
+    parent = root
+    for d in range(1, min(depth, nodes - 1) + 1):
+        layer = make_layer(rng, count, bitmap)
+        layer['layers'] = []
+        parent['layers'].append(layer)
+        if d < depth:
+            parents.append((layer, d))
+        parent = layer
+        count += 1
+
+    while count < nodes:
+        parent, d = rng.choice(parents)
+        layer = make_layer(rng, count, bitmap)
+        parent.setdefault('layers', []).append(layer)
+        if d + 1 < depth:
+            parents.append((layer, d + 1))
+        count += 1
+
+    return root
+
+
+def write(path, layout):
+    with open(path, 'w') as f:
+        json.dump(layout, f, separators=(',', ':'), sort_keys=True)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Generate synthetic pebble-layout layouts for benchmarking.')
+    parser.add_argument('output', help='layout JSON file, or a directory with --suite')
+    parser.add_argument('--nodes', type=int, default=100, help='number of layers, including the root')
+    parser.add_argument('--depth', type=int, default=4, help='depth of the deepest layer below the root')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--bitmap', default='icon', help='resource name for BitmapLayers; empty for none')
+    parser.add_argument('--suite', action='store_true',
+                        help='write bench-<nodes>-<depth>.json for a range of sizes and depths')
+    args = parser.parse_args(argv)
+
+    if args.suite:
+        if not os.path.isdir(args.output):
+            os.makedirs(args.output)
+        for nodes in SUITE_NODES:
+            for depth in SUITE_DEPTHS:
+                path = os.path.join(args.output, 'bench-{}-{}.json'.format(nodes, depth))
+                write(path, generate(nodes, depth, args.seed, args.bitmap))
+        return 0
+
+    if args.nodes < 1 or args.depth < 0 or (args.depth == 0) != (args.nodes == 1):
+        print('--nodes must be at least 1, and --depth 0 only fits a single layer', file=sys.stderr)
+        return 1
+    write(args.output, generate(args.nodes, args.depth, args.seed, args.bitmap))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))